@@ -0,0 +1,117 @@
+// Cost of one box-vs-box overlap test: collides() on two Motions, the scalar test on precomputed boxes and the
+// batched SIMD kernel (AABB_BATCH_WIDTH lanes), each testing every box against the next candidates in x order
+// as the sweep and prune broadphase does. Build with -DRB_BUILD_BENCHMARKS=ON (and -DRB_ENABLE_AVX2=ON for 8 lanes).
+
+// internal
+#include "physics_system.hpp"
+#include "aabb_batch.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int NUM_BODIES = 4096;
+const int CANDIDATES = 64; // per body, a multiple of every batch width
+const int REPEATS = 50;
+
+static volatile unsigned int sink;
+
+template <typename F>
+static double best_ns_per_test(F f)
+{
+	double best = 1e12;
+	for (int r = 0; r < REPEATS; r++)
+	{
+		auto t = Clock::now();
+		sink = f();
+		best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - t).count());
+	}
+	return best / ((double)(NUM_BODIES - CANDIDATES) * CANDIDATES);
+}
+
+int main()
+{
+	std::default_random_engine rng(427);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<Motion> motions(NUM_BODIES);
+	for (Motion& m : motions)
+	{
+		m.position = { uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+		m.scale = { 10.f + uniform(rng) * 90.f, 10.f + uniform(rng) * 90.f };
+		if (uniform(rng) < 0.5f)
+			m.scale.x = -m.scale.x; // facing left
+	}
+	std::sort(motions.begin(), motions.end(), [](const Motion& a, const Motion& b) {
+		return bounding_box(a).min.x < bounding_box(b).min.x;
+	});
+
+	std::vector<BroadphaseBox> boxes(NUM_BODIES);
+	AabbSoA soa;
+	soa.resize(NUM_BODIES);
+	for (int i = 0; i < NUM_BODIES; i++)
+	{
+		boxes[i] = bounding_box(motions[i]);
+		soa.set(i, boxes[i]);
+	}
+
+	// All three have to agree on every hit and its axis
+	for (int a = 0; a < NUM_BODIES - CANDIDATES; a++)
+	{
+		for (int b = a + 1; b < a + 1 + CANDIDATES; b += AABB_BATCH_WIDTH)
+		{
+			AabbBatchResult simd = aabb_overlap_batch(boxes[a], soa, b);
+			AabbBatchResult scalar = aabb_overlap_batch_scalar(boxes[a], soa, b);
+			for (unsigned int lane = 0; lane < AABB_BATCH_WIDTH; lane++)
+			{
+				int direction = collides(motions[a], motions[b + lane]);
+				unsigned int hit = direction != 0, x_axis = direction == 3 || direction == 4;
+				if (((simd.hits >> lane) & 1) != hit || ((scalar.hits >> lane) & 1) != hit ||
+					((simd.x_axis >> lane) & 1) != x_axis || ((scalar.x_axis >> lane) & 1) != x_axis)
+				{
+					printf("mismatch between bodies %d and %d\n", a, b + lane);
+					return EXIT_FAILURE;
+				}
+			}
+		}
+	}
+
+	double collides_ns = best_ns_per_test([&]() {
+		unsigned int hits = 0;
+		for (int a = 0; a < NUM_BODIES - CANDIDATES; a++)
+			for (int b = a + 1; b < a + 1 + CANDIDATES; b++)
+				hits += collides(motions[a], motions[b]) != 0;
+		return hits;
+	});
+	double scalar_ns = best_ns_per_test([&]() {
+		unsigned int hits = 0;
+		for (int a = 0; a < NUM_BODIES - CANDIDATES; a++)
+			for (int b = a + 1; b < a + 1 + CANDIDATES; b += AABB_BATCH_WIDTH)
+				hits += aabb_overlap_batch_scalar(boxes[a], soa, b).hits;
+		return hits;
+	});
+	double simd_ns = best_ns_per_test([&]() {
+		unsigned int hits = 0;
+		for (int a = 0; a < NUM_BODIES - CANDIDATES; a++)
+			for (int b = a + 1; b < a + 1 + CANDIDATES; b += AABB_BATCH_WIDTH)
+				hits += aabb_overlap_batch(boxes[a], soa, b).hits;
+		return hits;
+	});
+
+#if defined(RB_AABB_AVX2)
+	const char* kernel = "AVX2";
+#elif defined(RB_AABB_SSE2)
+	const char* kernel = "SSE2";
+#else
+	const char* kernel = "scalar";
+#endif
+	printf("%-24s %12s %8s\n", "test", "ns / pair", "speedup");
+	printf("%-24s %12.3f %7.2fx\n", "collides(Motion)", collides_ns, 1.0);
+	printf("%-24s %12.3f %7.2fx\n", "scalar, SoA boxes", scalar_ns, collides_ns / scalar_ns);
+	printf("%-17s x%-6u %12.3f %7.2fx\n", kernel, (unsigned int)AABB_BATCH_WIDTH, simd_ns, collides_ns / simd_ns);
+
+	return EXIT_SUCCESS;
+}
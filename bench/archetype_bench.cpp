@@ -0,0 +1,165 @@
+// Compares per-type ComponentContainers (queried with View) with Archetype chunk storage
+// on a scene with thousands of projectiles. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "tiny_ecs.hpp"
+#include "tiny_ecs_archetype.hpp"
+#include "components.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Blocks, players and guns: drawn and moved, but not projectiles
+const int NUM_WORLD_ENTITIES = 64;
+const int NUM_FRAMES = 200;
+const float DT = 1000.f / 120.f;
+
+static volatile float sink;
+
+// Everything the game keeps for a bullet, each in its own container as in ECSRegistry
+struct PerTypeScene
+{
+	ComponentContainer<Motion> motions;
+	ComponentContainer<RenderRequest> renderRequests;
+	ComponentContainer<Mesh*> meshPtrs;
+	ComponentContainer<Bullet> bullets;
+	ComponentContainer<vec3> colors;
+
+	void add_world(Entity e, const Motion& m) {
+		motions.insert(e, m);
+		renderRequests.insert(e, RenderRequest());
+		meshPtrs.insert(e, nullptr);
+	}
+
+	void add_projectile(Entity e, const Motion& m, int side) {
+		motions.insert(e, m);
+		renderRequests.insert(e, RenderRequest());
+		meshPtrs.insert(e, nullptr);
+		bullets.insert(e, { side });
+		colors.insert(e, vec3(1.f));
+	}
+
+	void remove(Entity e) {
+		motions.remove(e);
+		renderRequests.remove(e);
+		meshPtrs.remove(e);
+		bullets.remove(e);
+		colors.remove(e);
+	}
+
+	float frame() {
+		// integrate, as PhysicsSystem::step
+		for (Motion& m : motions.components)
+			m.position += m.velocity * (DT / 1000.f);
+
+		// per-side bullet query, as the out-of-screen and hit checks do
+		float acc = 0.f;
+		View<Bullet, Motion>(bullets, motions).each([&](Entity, Bullet& b, Motion& m) {
+			acc += (b.side == 1 ? m.position.x : -m.position.x);
+		});
+
+		// what RenderSystem::draw reads for each drawable
+		View<RenderRequest, Motion, Mesh*>(renderRequests, motions, meshPtrs).each([&](Entity, RenderRequest& r, Motion& m, Mesh*&) {
+			acc += m.position.y * m.scale.x + (float)r.used_texture;
+		});
+		return acc;
+	}
+};
+
+struct ArchetypeScene
+{
+	Archetype<Motion, RenderRequest, Mesh*> world;
+	Archetype<Motion, RenderRequest, Mesh*, Bullet, vec3> projectiles;
+
+	void add_world(Entity e, const Motion& m) { world.insert(e, m, RenderRequest(), nullptr); }
+	void add_projectile(Entity e, const Motion& m, int side) { projectiles.insert(e, m, RenderRequest(), nullptr, { side }, vec3(1.f)); }
+	void remove(Entity e) { projectiles.remove(e); world.remove(e); }
+
+	float frame() {
+		auto integrate = [](unsigned int n, Entity*, Motion* m) {
+			for (unsigned int i = 0; i < n; i++)
+				m[i].position += m[i].velocity * (DT / 1000.f);
+		};
+		world.each_chunk<Motion>(integrate);
+		projectiles.each_chunk<Motion>(integrate);
+
+		float acc = 0.f;
+		projectiles.each<Bullet, Motion>([&](Entity, Bullet& b, Motion& m) {
+			acc += (b.side == 1 ? m.position.x : -m.position.x);
+		});
+
+		auto draw = [&](Entity, RenderRequest& r, Motion& m) {
+			acc += m.position.y * m.scale.x + (float)r.used_texture;
+		};
+		world.each<RenderRequest, Motion>(draw);
+		projectiles.each<RenderRequest, Motion>(draw);
+		return acc;
+	}
+};
+
+template <class Scene>
+double run(int num_projectiles, unsigned int seed)
+{
+	std::default_random_engine rng(seed);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	auto random_motion = [&]() {
+		Motion m;
+		m.position = { uniform(rng) * 1200.f, uniform(rng) * 800.f };
+		m.velocity = { (uniform(rng) - 0.5f) * 800.f, 0.f };
+		m.scale = { 10.f, 10.f };
+		return m;
+	};
+
+	Scene scene;
+	std::vector<Entity> world_entities(NUM_WORLD_ENTITIES);
+	for (Entity e : world_entities)
+		scene.add_world(e, random_motion());
+	std::vector<Entity> projectiles(num_projectiles);
+	for (Entity e : projectiles)
+		scene.add_projectile(e, random_motion(), 1 + (e.index() & 1));
+
+	auto t = Clock::now();
+	float acc = 0.f;
+	for (int frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		// a few projectiles hit something and new ones are fired, which scrambles the per-type orders
+		for (int k = 0; k < num_projectiles / 50 + 1; k++)
+		{
+			size_t i = rng() % projectiles.size();
+			scene.remove(projectiles[i]);
+			Entity::destroy(projectiles[i]);
+			projectiles[i] = Entity();
+			scene.add_projectile(projectiles[i], random_motion(), 1 + (projectiles[i].index() & 1));
+		}
+		acc += scene.frame();
+	}
+	auto now = Clock::now();
+	sink = acc;
+
+	for (Entity e : projectiles) Entity::destroy(e);
+	for (Entity e : world_entities) Entity::destroy(e);
+	return (double)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
+}
+
+int main()
+{
+	const int counts[] = { 1000, 5000, 20000, 50000 };
+
+	printf("%12s %14s %15s %8s\n", "projectiles", "per-type (ms)", "archetype (ms)", "speedup");
+	for (int n : counts)
+	{
+		// Repeat and keep the best run to reduce noise
+		double per_type_ms = 1e9, archetype_ms = 1e9;
+		for (int r = 0; r < 5; r++) {
+			per_type_ms = std::min(per_type_ms, run<PerTypeScene>(n, 427 + r));
+			archetype_ms = std::min(archetype_ms, run<ArchetypeScene>(n, 427 + r));
+		}
+		printf("%12d %14.3f %15.3f %7.2fx\n", n, per_type_ms, archetype_ms, per_type_ms / archetype_ms);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+// Time spent finding colliding pairs per frame with the old all-pairs loop, the UniformGrid and the SweepAndPrune
+// broadphase, for 100, 1,000 and 10,000 bodies in the arena. The "moving" scenes move every body, the "stage" scenes
+// are closer to the game: mostly resting blocks and a few fast projectiles. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "broadphase.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int NUM_FRAMES = 50;
+const float DT = 1.f / 120.f;
+
+// Bodies bounce inside the arena so that the density stays the same over the run
+static void move(std::vector<Motion>& motions)
+{
+	for (Motion& m : motions)
+	{
+		m.position += m.velocity * DT;
+		if (m.position.x < 0.f || m.position.x > window_width_px) m.velocity.x = -m.velocity.x;
+		if (m.position.y < 0.f || m.position.y > window_height_px) m.velocity.y = -m.velocity.y;
+	}
+}
+
+// The loop PhysicsSystem::step used before the broadphase, testing every pair of bodies
+static size_t brute_force(const std::vector<BroadphaseBox>& boxes)
+{
+	size_t found = 0;
+	for (size_t i = 0; i < boxes.size(); i++)
+		for (size_t j = i + 1; j < boxes.size(); j++)
+			found += may_collide(boxes[i], boxes[j]) && boxes[i].min.x < boxes[j].max.x && boxes[j].min.x < boxes[i].max.x &&
+				boxes[i].min.y < boxes[j].max.y && boxes[j].min.y < boxes[i].max.y;
+	return found;
+}
+
+// Returns the average time per frame in ms, or a negative value if the pairs differ from the all-pairs loop
+static double run(Broadphase* broadphase, std::vector<Motion> motions, size_t& average_pairs)
+{
+	std::vector<BroadphaseBox> boxes(motions.size());
+	std::vector<BroadphasePair> pairs;
+	double ms = 0;
+	size_t total_pairs = 0;
+	for (int frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		move(motions);
+		for (size_t i = 0; i < motions.size(); i++)
+		{
+			boxes[i] = bounding_box(motions[i]);
+			// the resting blocks are static bodies
+			boxes[i].dynamic = motions[i].velocity != vec2(0.f, 0.f);
+		}
+
+		auto t = Clock::now();
+		size_t found;
+		if (broadphase) {
+			broadphase->find_pairs(boxes, pairs);
+			found = pairs.size();
+		} else {
+			found = brute_force(boxes);
+		}
+		ms += std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+
+		if (broadphase && found != brute_force(boxes))
+			return -1;
+		total_pairs += found;
+	}
+	average_pairs = total_pairs / NUM_FRAMES;
+	return ms / NUM_FRAMES;
+}
+
+static std::vector<Motion> make_scene(int n, float moving_fraction)
+{
+	std::default_random_engine rng(427);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<Motion> motions(n);
+	for (Motion& m : motions)
+	{
+		m.position = { uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+		if (uniform(rng) < moving_fraction) {
+			// bullet sized
+			m.velocity = { (uniform(rng) - 0.5f) * 800.f, (uniform(rng) - 0.5f) * 800.f };
+			m.scale = { 12.f, 12.f };
+		} else {
+			// resting block or platform
+			m.scale = { 60.f, 20.f };
+		}
+	}
+	return motions;
+}
+
+int main()
+{
+	const int counts[] = { 100, 1000, 10000 };
+
+	printf("%8s %8s %8s %16s %10s %10s\n", "scene", "bodies", "pairs", "all pairs (ms)", "grid (ms)", "sap (ms)");
+	for (int moving = 1; moving >= 0; moving--)
+	{
+		for (int n : counts)
+		{
+			std::vector<Motion> motions = make_scene(n, moving ? 1.f : 0.1f);
+			size_t average_pairs = 0;
+			UniformGrid grid;
+			SweepAndPrune sap;
+			double brute_ms = run(nullptr, motions, average_pairs);
+			double grid_ms = run(&grid, motions, average_pairs);
+			double sap_ms = run(&sap, motions, average_pairs);
+			if (grid_ms < 0 || sap_ms < 0)
+			{
+				printf("pairs differ from the all-pairs loop at %d bodies\n", n);
+				return EXIT_FAILURE;
+			}
+			printf("%8s %8d %8zu %16.3f %10.3f %10.3f\n", moving ? "moving" : "stage", n, average_pairs, brute_ms, grid_ms, sap_ms);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+// Self-check of the continuous collision for FastMovers: bullets from 500 to 20,000 px/s are fired at a 4 px wall
+// from many start offsets, so that the wall lies anywhere within one tick of travel. Every one of them has to
+// report the collision with the wall and end the step against or in it, never behind it. The same shots without
+// FastMover have to tunnel through at the higher speeds, which shows that the sweep is what catches them.
+// Runs with both broadphases and fails with a non-zero exit code. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "physics_system.hpp"
+
+// stlib
+#include <cstdio>
+
+const float TICK_MS = 1000.f / 120.f;
+const float WALL_X = 640.f;
+const float WALL_WIDTH = 4.f;
+const float BULLET_WIDTH = 15.f;
+const int NUM_OFFSETS = 64;
+
+enum RESULT { HIT, TUNNELLED, WRONG_POSITION, MISSED };
+
+// Fires one bullet at the wall and steps until it has hit it or is past it
+static RESULT shoot(PhysicsSystem& physics, float speed, float offset, bool fast_mover)
+{
+	registry.clear_all_components();
+
+	Entity wall;
+	registry.blocks.emplace(wall);
+	registry.physicsBodies.insert(wall, { BODY_TYPE::STATIC, COLLISION_LAYER::BLOCK });
+	Motion& wall_motion = registry.motions.emplace(wall);
+	wall_motion.position = { WALL_X, 400.f };
+	wall_motion.scale = { WALL_WIDTH, 200.f };
+
+	Entity bullet;
+	registry.bullets.insert(bullet, { 1 });
+	registry.physicsBodies.insert(bullet, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::BULLET });
+	if (fast_mover)
+		registry.fastMovers.emplace(bullet);
+	Motion& bullet_motion = registry.motions.emplace(bullet);
+	// offset is the fraction of a tick of travel the bullet starts behind a point one tick left of the wall
+	float travel = speed * TICK_MS / 1000.f;
+	bullet_motion.position = { WALL_X - WALL_WIDTH / 2 - BULLET_WIDTH / 2 - travel * (1.f + offset), 400.f };
+	bullet_motion.scale = { BULLET_WIDTH, 6.f };
+	bullet_motion.velocity = { speed, 0.f };
+
+	for (int tick = 0; tick < 10; tick++)
+	{
+		physics.step(TICK_MS);
+		bool hit = false;
+		for (uint i = 0; i < registry.collisions.size(); i++)
+			hit |= registry.collisions.entities[i] == bullet && registry.collisions.components[i].other == wall;
+		registry.collisions.clear();
+
+		// a swept hit is pulled back to where it first touched the wall, a discrete one overlaps it
+		float bullet_left = registry.motions.peek(bullet).position.x - BULLET_WIDTH / 2;
+		bool behind = bullet_left >= WALL_X + WALL_WIDTH / 2;
+		if (hit)
+			return behind ? WRONG_POSITION : HIT;
+		if (behind)
+			return TUNNELLED;
+	}
+	return MISSED;
+}
+
+int main()
+{
+	const float speeds[] = { 500.f, 2000.f, 6000.f, 20000.f };
+	const char* names[] = { "grid", "sap" };
+
+	printf("%6s %10s %14s %18s\n", "", "px/s", "ccd hits", "discrete tunnels");
+	for (int b = 0; b < 2; b++)
+	{
+		PhysicsSystem physics;
+		physics.set_broadphase(b == 0 ? BROADPHASE_TYPE::GRID : BROADPHASE_TYPE::SWEEP_AND_PRUNE);
+		for (float speed : speeds)
+		{
+			int hits = 0, tunnels = 0;
+			for (int k = 0; k < NUM_OFFSETS; k++)
+			{
+				float offset = (float)k / NUM_OFFSETS;
+				RESULT result = shoot(physics, speed, offset, true);
+				if (result != HIT) {
+					printf("%s: a fast mover at %.0f px/s (offset %.3f) %s\n", names[b], speed, offset,
+						result == TUNNELLED ? "went through the wall" : result == WRONG_POSITION ? "ended behind the wall" : "never reached the wall");
+					return EXIT_FAILURE;
+				}
+				hits++;
+				tunnels += shoot(physics, speed, offset, false) == TUNNELLED;
+			}
+			printf("%6s %10.0f %8d / %-3d %12d / %-3d\n", names[b], speed, hits, NUM_OFFSETS, tunnels, NUM_OFFSETS);
+			// a body that moves more than the wall and itself are wide per tick skips it from most offsets
+			if (speed * TICK_MS / 1000.f > 2 * (WALL_WIDTH + BULLET_WIDTH) && tunnels == 0) {
+				printf("%s: no discrete shot tunnelled at %.0f px/s, the check does not exercise the sweep\n", names[b], speed);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf("ok\n");
+	return EXIT_SUCCESS;
+}
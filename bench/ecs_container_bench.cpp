@@ -0,0 +1,118 @@
+// Compares the sparse-set ComponentContainer with the previous hash-map based container
+// as the number of entities grows. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "tiny_ecs.hpp"
+#include "components.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// The original container, kept here as the baseline: one std::unordered_map lookup per has()/get()
+template <typename Component>
+class MapComponentContainer
+{
+	std::unordered_map<unsigned int, unsigned int> map_entity_componentID;
+public:
+	std::vector<Component> components;
+	std::vector<Entity> entities;
+
+	Component& insert(Entity e, Component c)
+	{
+		assert(!has(e) && "Entity already contained in ECS registry");
+		map_entity_componentID[e] = (unsigned int)components.size();
+		components.push_back(std::move(c));
+		entities.push_back(e);
+		return components.back();
+	}
+
+	Component& get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return components[map_entity_componentID[e]];
+	}
+
+	bool has(Entity entity) {
+		return map_entity_componentID.count(entity) > 0;
+	}
+
+	void remove(Entity e)
+	{
+		if (has(e))
+		{
+			int cID = map_entity_componentID[e];
+			components[cID] = std::move(components.back());
+			entities[cID] = entities.back();
+			map_entity_componentID[entities.back()] = cID;
+			map_entity_componentID.erase(e);
+			components.pop_back();
+			entities.pop_back();
+		}
+	}
+};
+
+// Sink so that the optimizer keeps the lookups
+static volatile float sink;
+
+template <class Container>
+double run(std::vector<Entity>& all, const std::vector<Entity>& queries, const std::vector<Entity>& removals)
+{
+	auto t = Clock::now();
+	Container container;
+
+	for (Entity e : all)
+		container.insert(e, Motion());
+
+	// Roughly what PhysicsSystem::step and RenderSystem::draw do: probe by entity, then read
+	float acc = 0.f;
+	for (int pass = 0; pass < 8; pass++)
+		for (Entity e : queries)
+			if (container.has(e))
+				acc += container.get(e).position.x + 1.f;
+
+	for (Entity e : removals)
+		container.remove(e);
+
+	sink = acc;
+	auto now = Clock::now();
+	return (double)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
+}
+
+int main()
+{
+	std::default_random_engine rng(427);
+	const int counts[] = { 100, 1000, 10000, 100000 };
+
+	printf("%10s %14s %14s %8s\n", "entities", "map (ms)", "sparse (ms)", "speedup");
+	for (int n : counts)
+	{
+		std::vector<Entity> all(n);
+
+		// Half of the probes miss, as when a loop asks registry.players.has() for every motion
+		std::vector<Entity> queries;
+		std::vector<Entity> misses(n);
+		queries.reserve(2 * n);
+		for (int i = 0; i < n; i++) {
+			queries.push_back(all[i]);
+			queries.push_back(misses[i]);
+		}
+		std::shuffle(queries.begin(), queries.end(), rng);
+
+		std::vector<Entity> removals(all.begin(), all.begin() + n / 2);
+		std::shuffle(removals.begin(), removals.end(), rng);
+
+		// Repeat and keep the best run to reduce noise
+		double map_ms = 1e9, sparse_ms = 1e9;
+		for (int r = 0; r < 5; r++) {
+			map_ms = std::min(map_ms, run<MapComponentContainer<Motion>>(all, queries, removals));
+			sparse_ms = std::min(sparse_ms, run<ComponentContainer<Motion>>(all, queries, removals));
+		}
+		printf("%10d %14.3f %14.3f %7.2fx\n", n, map_ms, sparse_ms, map_ms / sparse_ms);
+	}
+
+	return EXIT_SUCCESS;
+}
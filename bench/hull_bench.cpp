@@ -0,0 +1,93 @@
+// Cost of one mesh collision test against the number of mesh vertices: transforming every vertex of the mesh and
+// testing it against the box, as PhysicsSystem did for each player-portal pair, compared with the separating axis
+// test on a hull that was transformed once. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "hull.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// The old test: any transformed vertex inside the box
+static bool vertices_in_box(const Mesh& mesh, const Motion& motion, const BroadphaseBox& box, std::vector<vec2>& transformed)
+{
+	transformed.clear();
+	float cos_theta = cos(motion.angle);
+	float sin_theta = sin(motion.angle);
+	for (const ColoredVertex& vertex : mesh.vertices)
+	{
+		vec2 v = { vertex.position.x * motion.scale.x, vertex.position.y * motion.scale.y };
+		transformed.push_back(vec2(v.x * cos_theta - v.y * sin_theta, v.x * sin_theta + v.y * cos_theta) + motion.position);
+	}
+	for (uint16_t index : mesh.vertex_indices)
+	{
+		vec2 p = transformed[index];
+		if (p.x >= box.min.x && p.x <= box.max.x && p.y >= box.min.y && p.y <= box.max.y)
+			return true;
+	}
+	return false;
+}
+
+int main()
+{
+	const int vertex_counts[] = { 16, 64, 256, 1024 };
+	const int NUM_BOXES = 10000;
+
+	std::default_random_engine rng(22);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<BroadphaseBox> boxes(NUM_BOXES);
+	for (BroadphaseBox& box : boxes)
+	{
+		// braces, so that x is drawn before y
+		box.min = vec2{ uniform(rng) * 300.f, uniform(rng) * 300.f };
+		box.max = box.min + vec2(75.f, 80.f);
+	}
+	Motion motion;
+	motion.position = { 150.f, 150.f };
+	motion.scale = { 150.f, 200.f };
+	motion.angle = 0.3f;
+
+	printf("%10s %12s %20s %16s %10s\n", "vertices", "hull size", "vertices (ns/test)", "hull (ns/test)", "speedup");
+	for (int n : vertex_counts)
+	{
+		// a ring with an inner ring, so that half of the vertices are not on the hull
+		Mesh mesh;
+		for (int k = 0; k < n; k++)
+		{
+			float a = 2.f * M_PI * k / n;
+			float r = (k & 1) ? 0.3f : 0.5f;
+			mesh.vertices.push_back({ { r * cos(a), r * sin(a), 0.f }, vec3(1.f) });
+			mesh.vertex_indices.push_back((uint16_t)k);
+		}
+		convex_hull(mesh.vertices, mesh.hull);
+
+		std::vector<vec2> transformed;
+		WorldHull world_hull;
+		auto t = Clock::now();
+		int vertex_hits = 0;
+		for (const BroadphaseBox& box : boxes)
+			vertex_hits += vertices_in_box(mesh, motion, box, transformed);
+		double vertex_ns = std::chrono::duration<double, std::nano>(Clock::now() - t).count() / NUM_BOXES;
+
+		t = Clock::now();
+		transform_hull(mesh.hull, motion, world_hull);
+		int hull_hits = 0;
+		for (const BroadphaseBox& box : boxes)
+			hull_hits += hull_overlaps_box(world_hull, box);
+		double hull_ns = std::chrono::duration<double, std::nano>(Clock::now() - t).count() / NUM_BOXES;
+
+		// the hull also finds boxes inside the mesh or crossed by an edge, never fewer than the vertices
+		if (hull_hits < vertex_hits)
+		{
+			printf("hull test misses boxes that contain a vertex\n");
+			return EXIT_FAILURE;
+		}
+		printf("%10d %12zu %20.1f %16.1f %9.1fx\n", n, mesh.hull.size(), vertex_ns, hull_ns, vertex_ns / hull_ns);
+	}
+
+	return EXIT_SUCCESS;
+}
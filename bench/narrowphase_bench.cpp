@@ -0,0 +1,121 @@
+// PhysicsSystem::step on a stress scene with the narrowphase on 1, 2, 4 and 8 threads: many players crowding
+// portals (the hull test of a detailed mesh) and bullets crossing each other. Every thread count has to produce
+// the same collisions in the same order as the single threaded run. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "physics_system.hpp"
+
+// stlib
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int NUM_PLAYERS = 400;
+const int NUM_PORTALS = 60;
+const int NUM_BULLETS = 4000;
+const int NUM_STEPS = 20;
+
+struct Recorded
+{
+	unsigned int entity;
+	unsigned int other;
+	int direction;
+	bool operator!=(const Recorded& r) const { return entity != r.entity || other != r.other || direction != r.direction; }
+};
+
+int main()
+{
+	// a portal outline with many vertices, all on its hull
+	Mesh portal_mesh;
+	for (int k = 0; k < 256; k++)
+	{
+		float a = 2.f * M_PI * k / 256;
+		portal_mesh.vertices.push_back({ { 0.5f * cos(a), 0.5f * sin(a), 0.f }, vec3(1.f) });
+		portal_mesh.vertex_indices.push_back((uint16_t)k);
+	}
+	convex_hull(portal_mesh.vertices, portal_mesh.hull);
+
+	std::default_random_engine rng(427);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	auto random_position = [&]() {
+		// braces, so that x is drawn before y
+		return vec2{ uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+	};
+	std::vector<std::pair<Entity, Motion>> start;
+	for (int i = 0; i < NUM_PORTALS; i++)
+	{
+		Entity e;
+		registry.portals.emplace(e);
+		registry.meshPtrs.emplace(e, &portal_mesh);
+		registry.physicsBodies.insert(e, { BODY_TYPE::STATIC, COLLISION_LAYER::PORTAL });
+		Motion& m = registry.motions.emplace(e);
+		m.position = random_position();
+		m.scale = { 150.f, 200.f };
+		start.push_back({ e, m });
+	}
+	for (int i = 0; i < NUM_PLAYERS; i++)
+	{
+		Entity e;
+		Player player;
+		player.side = 1 + (i & 1);
+		registry.players.insert(e, player);
+		registry.physicsBodies.insert(e, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::PLAYER });
+		Motion& m = registry.motions.emplace(e);
+		m.position = random_position();
+		m.scale = { 75.f, 80.f }; // PLAYER_WIDTH x PLAYER_HEIGHT, world_init.hpp would pull in the renderer
+		start.push_back({ e, m });
+	}
+	for (int i = 0; i < NUM_BULLETS; i++)
+	{
+		Entity e;
+		registry.bullets.insert(e, { 1 + (i & 1) });
+		registry.physicsBodies.insert(e, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::BULLET });
+		registry.fastMovers.emplace(e);
+		Motion& m = registry.motions.emplace(e);
+		m.position = random_position();
+		m.velocity = { (uniform(rng) - 0.5f) * 1000.f, (uniform(rng) - 0.5f) * 1000.f };
+		m.scale = { 15.f, 6.f };
+		start.push_back({ e, m });
+	}
+
+	PhysicsSystem physics;
+	// every step starts from the same scene, the players would otherwise fall asleep during the later runs
+	physics.set_sleep_ticks(0);
+	std::vector<Recorded> reference;
+	printf("%8s %12s %12s %8s\n", "threads", "collisions", "step (ms)", "speedup");
+	double single_ms = 0;
+	for (unsigned int threads : { 1u, 2u, 4u, 8u })
+	{
+		physics.set_thread_count(threads);
+		double best_ms = 1e12;
+		std::vector<Recorded> recorded;
+		for (int s = 0; s < NUM_STEPS; s++)
+		{
+			for (auto& body : start)
+				registry.motions.get(body.first) = body.second;
+			registry.collisions.clear();
+
+			auto t = Clock::now();
+			physics.step(1000.f / 120.f);
+			best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(Clock::now() - t).count());
+
+			recorded.clear();
+			for (uint c = 0; c < registry.collisions.size(); c++)
+				recorded.push_back({ registry.collisions.entities[c], registry.collisions.components[c].other, registry.collisions.components[c].direction });
+		}
+
+		if (threads == 1) {
+			reference = recorded;
+			single_ms = best_ms;
+		} else if (recorded.size() != reference.size() || !std::equal(recorded.begin(), recorded.end(), reference.begin(),
+			[](const Recorded& a, const Recorded& b) { return !(a != b); })) {
+			printf("collisions on %u threads differ from the single threaded run\n", threads);
+			return EXIT_FAILURE;
+		}
+		printf("%8u %12zu %12.3f %7.2fx\n", threads, recorded.size(), best_ms, single_ms / best_ms);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+// Cost of the PhysicsSystem spatial queries with the UniformGrid and the SweepAndPrune broadphase, compared with
+// the linear scan over every Motion that the gameplay code used before (item spawning, explosions, lasers), for
+// 100, 1,000 and 10,000 bodies. Every query has to find the same bodies as the scan, also after bodies were moved,
+// created and removed since the last step. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "physics_system.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int NUM_QUERIES = 2000;
+
+struct Query
+{
+	vec2 min;
+	vec2 max;
+	vec2 center;
+	float radius;
+	vec2 start;
+	vec2 end;
+};
+
+static void populate(int n, std::default_random_engine& rng)
+{
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	// a background, which the sweep and prune lists separately
+	Entity background;
+	registry.physicsBodies.insert(background, { BODY_TYPE::STATIC, COLLISION_LAYER::NONE });
+	Motion& m = registry.motions.emplace(background);
+	m.position = { window_width_px / 2.f, window_height_px / 2.f };
+	m.scale = { (float)window_width_px, (float)window_height_px };
+	for (int i = 1; i < n; i++)
+	{
+		Entity e;
+		bool player = i % 10 == 0;
+		registry.physicsBodies.insert(e, { BODY_TYPE::DYNAMIC, player ? COLLISION_LAYER::PLAYER : COLLISION_LAYER::BULLET });
+		Motion& motion = registry.motions.emplace(e);
+		// braces, so that x is drawn before y
+		motion.position = vec2{ uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+		motion.scale = player ? vec2(75.f, 80.f) : vec2(15.f, 6.f);
+	}
+}
+
+// The scans the queries replace
+static void scan_aabb(const Query& q, unsigned int mask, std::vector<Entity>& found)
+{
+	found.clear();
+	Motion query_motion;
+	query_motion.position = (q.min + q.max) / 2.f;
+	query_motion.scale = q.max - q.min;
+	for (uint i = 0; i < registry.motions.size(); i++)
+	{
+		PhysicsBody* body = registry.physicsBodies.try_peek(registry.motions.entities[i]);
+		if ((mask & layer_bit(body->layer)) && collides(query_motion, registry.motions.components[i]))
+			found.push_back(registry.motions.entities[i]);
+	}
+}
+
+static void scan_circle(const Query& q, unsigned int mask, std::vector<Entity>& found)
+{
+	found.clear();
+	for (uint i = 0; i < registry.motions.size(); i++)
+	{
+		PhysicsBody* body = registry.physicsBodies.try_peek(registry.motions.entities[i]);
+		BroadphaseBox box = bounding_box(registry.motions.components[i]);
+		vec2 d = clamp(q.center, box.min, box.max) - q.center;
+		if ((mask & layer_bit(body->layer)) && dot(d, d) <= q.radius * q.radius)
+			found.push_back(registry.motions.entities[i]);
+	}
+}
+
+static void scan_segment(const Query& q, unsigned int mask, std::vector<Entity>& found)
+{
+	found.clear();
+	for (uint i = 0; i < registry.motions.size(); i++)
+	{
+		PhysicsBody* body = registry.physicsBodies.try_peek(registry.motions.entities[i]);
+		float t;
+		bool x_axis;
+		if ((mask & layer_bit(body->layer)) && aabb_sweep({ q.start, q.start }, q.end - q.start, bounding_box(registry.motions.components[i]), t, x_axis))
+			found.push_back(registry.motions.entities[i]);
+	}
+}
+
+static bool same(std::vector<Entity> a, std::vector<Entity> b)
+{
+	auto by_id = [](Entity x, Entity y) { return (unsigned int)x < (unsigned int)y; };
+	std::sort(a.begin(), a.end(), by_id);
+	std::sort(b.begin(), b.end(), by_id);
+	return a == b;
+}
+
+const unsigned int everything = ~0u;
+const unsigned int players = layer_bit(COLLISION_LAYER::PLAYER);
+const char* names[] = { "overlap_aabb", "overlap_circle", "raycast" };
+
+// Every query of the kind against the scan
+static bool finds_the_same(PhysicsSystem& physics, const std::vector<Query>& queries, int kind)
+{
+	std::vector<Entity> expected, found;
+	std::vector<QueryHit> hits;
+	for (const Query& q : queries)
+	{
+		if (kind == 0) {
+			scan_aabb(q, everything, expected);
+			physics.overlap_aabb(q.min, q.max, everything, found);
+		} else if (kind == 1) {
+			scan_circle(q, players, expected);
+			physics.overlap_circle(q.center, q.radius, players, found);
+		} else {
+			scan_segment(q, players, expected);
+			physics.segment_sweep(q.start, q.end, { 0.f, 0.f }, players, hits);
+			found.clear();
+			for (const QueryHit& hit : hits)
+				found.push_back(hit.entity);
+		}
+		if (!same(expected, found)) {
+			printf("%s finds other bodies than the scan\n", names[kind]);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	const int counts[] = { 100, 1000, 10000 };
+
+	printf("%8s %-12s %12s %12s %12s\n", "bodies", "query", "scan (us)", "grid (us)", "sap (us)");
+	for (int n : counts)
+	{
+		std::default_random_engine rng(25);
+		std::uniform_real_distribution<float> uniform(0.f, 1.f);
+		populate(n, rng);
+		std::vector<Query> queries(NUM_QUERIES);
+		for (Query& q : queries)
+		{
+			// item sized boxes, explosion sized circles and horizontal laser shots
+			q.min = vec2{ uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+			q.max = q.min + vec2(30.f, 45.f);
+			q.center = q.min;
+			q.radius = 150.f;
+			q.start = q.min;
+			q.end = q.start + vec2(uniform(rng) < 0.5f ? -1210.f : 1210.f, 0.f);
+		}
+
+		PhysicsSystem grid, sap;
+		grid.set_broadphase(BROADPHASE_TYPE::GRID);
+		sap.set_broadphase(BROADPHASE_TYPE::SWEEP_AND_PRUNE);
+		grid.step(0.f);
+		sap.step(0.f);
+		registry.collisions.clear();
+
+		std::vector<Entity> found;
+		std::vector<QueryHit> hits;
+		for (int kind = 0; kind < 3; kind++)
+		{
+			double us[3] = { 0, 0, 0 };
+			for (int system = 0; system < 3; system++)
+			{
+				PhysicsSystem& physics = system == 1 ? grid : sap;
+				auto t = Clock::now();
+				for (const Query& q : queries)
+				{
+					if (system == 0) {
+						if (kind == 0) scan_aabb(q, everything, found);
+						else if (kind == 1) scan_circle(q, players, found);
+						else scan_segment(q, players, found);
+					} else if (kind == 0) {
+						physics.overlap_aabb(q.min, q.max, everything, found);
+					} else if (kind == 1) {
+						physics.overlap_circle(q.center, q.radius, players, found);
+					} else {
+						// all hits rather than the first, to compare them with the scan
+						physics.segment_sweep(q.start, q.end, { 0.f, 0.f }, players, hits);
+						found.clear();
+						for (const QueryHit& hit : hits)
+							found.push_back(hit.entity);
+					}
+				}
+				us[system] = std::chrono::duration<double, std::micro>(Clock::now() - t).count() / NUM_QUERIES;
+				if (system > 0 && !finds_the_same(physics, queries, kind))
+					return EXIT_FAILURE;
+			}
+			printf("%8d %-12s %12.2f %12.2f %12.2f\n", n, names[kind], us[0], us[1], us[2]);
+		}
+
+		// what the gameplay does between two steps: teleports through portals, landing snaps, spawns and removals
+		for (uint i = 1; i < registry.motions.size(); i += 20)
+			registry.motions.get(registry.motions.entities[i]).position = vec2{ uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+		for (uint i = 2; i < registry.motions.size(); i += 20)
+			registry.motions.get(registry.motions.entities[i]).position.y += 4.f;
+		for (int i = 0; i < 10; i++)
+		{
+			Entity e;
+			registry.physicsBodies.insert(e, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::PLAYER });
+			Motion& motion = registry.motions.emplace(e);
+			motion.position = vec2{ uniform(rng) * window_width_px, uniform(rng) * window_height_px };
+			motion.scale = { 75.f, 80.f };
+		}
+		for (int i = 0; i < 10; i++)
+			registry.remove_all_components_of(registry.motions.entities[1 + i * (n - 11) / 10]);
+		for (int kind = 0; kind < 3; kind++)
+			if (!finds_the_same(grid, queries, kind) || !finds_the_same(sap, queries, kind)) {
+				printf("after changes since the step\n");
+				return EXIT_FAILURE;
+			}
+
+		registry.clear_all_components();
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+// Replays a recorded input stream through the game at 120 Hz and prints a hash of the state, to check that a build is
+// deterministic. The game runs as in main(), WorldSystem::step, PhysicsSystem::step and WorldSystem::handle_collisions
+// each tick, without a window, renderer or audio device. Build it with -DRB_FIXED_POINT_PHYSICS=ON and different
+// compilers or flags (e.g. -O0 and -O3 -ffast-math -march=native) and compare the hashes, or pass the expected hash:
+//   replay_hash 0123456789abcdef
+// ctest does so with the reference hash of fixed point builds. With float physics the hashes usually differ between
+// such builds. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// gl3w, as in main.cpp, for the few GL helpers the game code links against
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+// internal
+#include "physics_system.hpp"
+#include "world_system.hpp"
+
+// stlib
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int NUM_TICKS = 1200; // 10 seconds
+const float TICK_MS = 1000.f / 120.f;
+// The stage without portals, whose meshes would need the renderer. The first rounds have no lasers and no items,
+// which are placed with std::random_device.
+const int STAGE = 5;
+
+struct KeyEvent
+{
+	int tick;
+	int key;
+	int action;
+};
+
+// Recorded from a two player session, sorted by tick
+const KeyEvent recording[] = {
+	{ 26, GLFW_KEY_UP, GLFW_PRESS }, { 27, GLFW_KEY_UP, GLFW_RELEASE }, { 44, GLFW_KEY_RIGHT, GLFW_PRESS },
+	{ 67, GLFW_KEY_Q, GLFW_PRESS }, { 68, GLFW_KEY_Q, GLFW_RELEASE }, { 98, GLFW_KEY_PERIOD, GLFW_PRESS },
+	{ 99, GLFW_KEY_PERIOD, GLFW_RELEASE }, { 132, GLFW_KEY_Q, GLFW_PRESS }, { 133, GLFW_KEY_Q, GLFW_RELEASE },
+	{ 155, GLFW_KEY_D, GLFW_PRESS }, { 199, GLFW_KEY_D, GLFW_RELEASE }, { 225, GLFW_KEY_PERIOD, GLFW_PRESS },
+	{ 226, GLFW_KEY_PERIOD, GLFW_RELEASE }, { 254, GLFW_KEY_A, GLFW_PRESS }, { 292, GLFW_KEY_UP, GLFW_PRESS },
+	{ 293, GLFW_KEY_UP, GLFW_RELEASE }, { 311, GLFW_KEY_A, GLFW_RELEASE }, { 311, GLFW_KEY_D, GLFW_PRESS },
+	{ 321, GLFW_KEY_PERIOD, GLFW_PRESS }, { 322, GLFW_KEY_PERIOD, GLFW_RELEASE },
+	{ 374, GLFW_KEY_D, GLFW_RELEASE }, { 380, GLFW_KEY_UP, GLFW_PRESS }, { 381, GLFW_KEY_UP, GLFW_RELEASE },
+	{ 404, GLFW_KEY_RIGHT, GLFW_RELEASE }, { 404, GLFW_KEY_LEFT, GLFW_PRESS },
+	{ 452, GLFW_KEY_PERIOD, GLFW_PRESS }, { 453, GLFW_KEY_PERIOD, GLFW_RELEASE },
+	{ 465, GLFW_KEY_A, GLFW_PRESS }, { 505, GLFW_KEY_Q, GLFW_PRESS }, { 506, GLFW_KEY_Q, GLFW_RELEASE },
+	{ 514, GLFW_KEY_LEFT, GLFW_RELEASE }, { 514, GLFW_KEY_RIGHT, GLFW_PRESS },
+	{ 572, GLFW_KEY_A, GLFW_RELEASE }, { 599, GLFW_KEY_PERIOD, GLFW_PRESS },
+	{ 600, GLFW_KEY_PERIOD, GLFW_RELEASE }, { 623, GLFW_KEY_RIGHT, GLFW_RELEASE },
+	{ 624, GLFW_KEY_A, GLFW_PRESS }, { 637, GLFW_KEY_Q, GLFW_PRESS }, { 638, GLFW_KEY_Q, GLFW_RELEASE },
+	{ 659, GLFW_KEY_Q, GLFW_PRESS }, { 660, GLFW_KEY_Q, GLFW_RELEASE }, { 673, GLFW_KEY_RIGHT, GLFW_PRESS },
+	{ 715, GLFW_KEY_PERIOD, GLFW_PRESS }, { 716, GLFW_KEY_PERIOD, GLFW_RELEASE },
+	{ 718, GLFW_KEY_Q, GLFW_PRESS }, { 719, GLFW_KEY_Q, GLFW_RELEASE }, { 743, GLFW_KEY_PERIOD, GLFW_PRESS },
+	{ 744, GLFW_KEY_PERIOD, GLFW_RELEASE }, { 773, GLFW_KEY_W, GLFW_PRESS }, { 774, GLFW_KEY_W, GLFW_RELEASE },
+	{ 866, GLFW_KEY_RIGHT, GLFW_RELEASE }, { 871, GLFW_KEY_W, GLFW_PRESS }, { 872, GLFW_KEY_W, GLFW_RELEASE },
+	{ 886, GLFW_KEY_UP, GLFW_PRESS }, { 887, GLFW_KEY_UP, GLFW_RELEASE }, { 936, GLFW_KEY_Q, GLFW_PRESS },
+	{ 937, GLFW_KEY_Q, GLFW_RELEASE }, { 958, GLFW_KEY_A, GLFW_RELEASE }, { 990, GLFW_KEY_W, GLFW_PRESS },
+	{ 990, GLFW_KEY_PERIOD, GLFW_PRESS }, { 991, GLFW_KEY_W, GLFW_RELEASE },
+	{ 991, GLFW_KEY_PERIOD, GLFW_RELEASE }, { 1006, GLFW_KEY_Q, GLFW_PRESS },
+	{ 1007, GLFW_KEY_Q, GLFW_RELEASE }, { 1015, GLFW_KEY_UP, GLFW_PRESS }, { 1016, GLFW_KEY_UP, GLFW_RELEASE },
+	{ 1052, GLFW_KEY_LEFT, GLFW_PRESS }, { 1059, GLFW_KEY_W, GLFW_PRESS }, { 1060, GLFW_KEY_W, GLFW_RELEASE },
+	{ 1094, GLFW_KEY_UP, GLFW_PRESS }, { 1095, GLFW_KEY_UP, GLFW_RELEASE }, { 1113, GLFW_KEY_A, GLFW_PRESS },
+	{ 1138, GLFW_KEY_W, GLFW_PRESS }, { 1139, GLFW_KEY_W, GLFW_RELEASE }, { 1159, GLFW_KEY_UP, GLFW_PRESS },
+	{ 1160, GLFW_KEY_UP, GLFW_RELEASE }, { 1171, GLFW_KEY_A, GLFW_RELEASE },
+};
+
+// FNV-1a over the bits of the state
+static uint64_t hash_state()
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&](const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t b = 0; b < size; b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ull;
+	};
+	for (uint i = 0; i < registry.motions.size(); i++)
+	{
+		unsigned int id = registry.motions.entities[i];
+		const Motion& motion = registry.motions.components[i];
+		add(&id, sizeof(id));
+		add(&motion.position, sizeof(motion.position));
+		add(&motion.velocity, sizeof(motion.velocity));
+	}
+	for (const Player& player : registry.players.components)
+		add(&player.health, sizeof(player.health));
+	return hash;
+}
+
+int main(int argc, char* argv[])
+{
+	// what RenderSystem::init and the stage selection screen would have done
+	registry.screenStates.emplace(Entity());
+	registry.intro = false;
+	registry.stageSelection = STAGE;
+
+	// never drawn, and never destroyed as its destructor frees GL objects
+	RenderSystem* renderer = new RenderSystem();
+	PhysicsSystem physics;
+	WorldSystem world;
+	world.seed_random(0);
+	world.init(renderer, &physics);
+
+	size_t next_event = 0;
+	double physics_ms = 0;
+	for (int tick = 0; tick < NUM_TICKS; tick++)
+	{
+		ChangeTick::advance();
+		for (; next_event < sizeof(recording) / sizeof(recording[0]) && recording[next_event].tick == tick; next_event++)
+			world.replay_key(recording[next_event].key, recording[next_event].action);
+
+		world.step(TICK_MS);
+		registry.flush_commands();
+		auto t = Clock::now();
+		physics.step(TICK_MS);
+		physics_ms += std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+		world.handle_collisions();
+		registry.flush_commands();
+
+		if ((tick + 1) % 120 == 0)
+			printf("tick %5d  state %016" PRIx64 "\n", tick + 1, hash_state());
+	}
+
+	uint64_t hash = hash_state();
+#ifdef RB_FIXED_POINT_PHYSICS
+	const char* mode = "fixed point";
+#else
+	const char* mode = "float";
+#endif
+	printf("%s physics, %.3f ms per tick, final state %016" PRIx64 "\n", mode, physics_ms / NUM_TICKS, hash);
+
+	if (argc > 1 && strtoull(argv[1], nullptr, 16) != hash) {
+		printf("expected %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
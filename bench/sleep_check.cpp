@@ -0,0 +1,123 @@
+// Self-check of body sleeping:
+// - a player that landed on a block falls asleep after the sleep ticks, and then the steps leave its Motion version
+//   alone, so that nothing downstream sees it as changed
+// - a bullet that reaches the sleeping player reports the collision and wakes it
+// - changing the velocity of a sleeping player (input) wakes it and it moves again
+// Runs with both broadphases and fails with a non-zero exit code. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "physics_system.hpp"
+
+// stlib
+#include <cstdio>
+
+const float TICK_MS = 1000.f / 120.f;
+const unsigned int SLEEP_TICKS = 60;
+
+static bool check(bool condition, const char* what, const char* broadphase)
+{
+	if (!condition)
+		printf("%s: %s\n", broadphase, what);
+	return condition;
+}
+
+// The landing of WorldSystem::handle_collisions, returns whether the player touched something other than the block
+static bool step(PhysicsSystem& physics, Entity player, Entity block)
+{
+	ChangeTick::advance();
+	physics.step(TICK_MS);
+	bool touched = false;
+	for (uint i = 0; i < registry.collisions.size(); i++)
+	{
+		if (registry.collisions.entities[i] != player)
+			continue;
+		Entity other = registry.collisions.components[i].other;
+		touched |= other != block;
+		if (other == block && registry.collisions.components[i].direction == 1) {
+			Motion& motion = registry.motions.get(player);
+			const Motion& motion_block = registry.motions.peek(block);
+			if (motion.velocity.y >= 0.f) {
+				motion.velocity.y = 0.f;
+				motion.position.y = motion_block.position.y - (motion_block.scale.y / 2) - abs(motion.scale.y / 2) + 1;
+			}
+		}
+	}
+	registry.collisions.clear();
+	return touched;
+}
+
+static bool run(BROADPHASE_TYPE type, const char* name)
+{
+	registry.clear_all_components();
+	PhysicsSystem physics;
+	physics.set_broadphase(type);
+	physics.set_sleep_ticks(SLEEP_TICKS);
+
+	// the player first, collisions report the direction as seen from the first body
+	Entity player;
+	registry.players.emplace(player);
+	registry.physicsBodies.insert(player, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::PLAYER });
+	Motion& player_motion = registry.motions.emplace(player);
+	player_motion.position = { 640.f, 550.f };
+	player_motion.scale = { 75.f, 80.f };
+	registry.gravities.emplace(player).drag = true;
+
+	Entity block;
+	registry.blocks.emplace(block);
+	registry.physicsBodies.insert(block, { BODY_TYPE::STATIC, COLLISION_LAYER::BLOCK });
+	Motion& block_motion = registry.motions.emplace(block);
+	block_motion.position = { 640.f, 680.f };
+	block_motion.scale = { 1280.f, 40.f };
+
+	// falls onto the block, lands and keeps still until it sleeps
+	for (int tick = 0; tick < 120 + (int)SLEEP_TICKS && !registry.physicsBodies.peek(player).asleep; tick++)
+		step(physics, player, block);
+	if (!check(registry.physicsBodies.peek(player).asleep, "the player on the block never fell asleep", name))
+		return false;
+
+	vec2 resting = registry.motions.peek(player).position;
+	unsigned int version = registry.motions.version(player);
+	for (int tick = 0; tick < 30; tick++)
+		step(physics, player, block);
+	if (!check(registry.physicsBodies.peek(player).asleep, "the sleeping player woke up by itself", name) ||
+		!check(registry.motions.version(player) == version, "the steps changed the version of a sleeping player", name) ||
+		!check(registry.motions.peek(player).position == resting, "a sleeping player moved", name))
+		return false;
+
+	// a bullet from the left hits it within a few ticks
+	Entity bullet;
+	registry.bullets.insert(bullet, { 1 });
+	registry.physicsBodies.insert(bullet, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::BULLET });
+	registry.fastMovers.emplace(bullet);
+	Motion& bullet_motion = registry.motions.emplace(bullet);
+	bullet_motion.position = resting - vec2(100.f, 0.f);
+	bullet_motion.scale = { 15.f, 6.f };
+	bullet_motion.velocity = { 500.f, 0.f };
+	bool hit = false;
+	for (int tick = 0; tick < 30 && !hit; tick++)
+		hit = step(physics, player, block);
+	if (!check(hit, "a bullet went through a sleeping player", name) ||
+		!check(!registry.physicsBodies.peek(player).asleep, "a bullet hit did not wake the player", name))
+		return false;
+	registry.remove_all_components_of(bullet);
+
+	// falls asleep again, then input sets it moving
+	for (int tick = 0; tick < 2 * (int)SLEEP_TICKS && !registry.physicsBodies.peek(player).asleep; tick++)
+		step(physics, player, block);
+	if (!check(registry.physicsBodies.peek(player).asleep, "the player did not fall asleep again", name))
+		return false;
+	registry.motions.get(player).velocity.x = 200.f;
+	step(physics, player, block);
+	if (!check(!registry.physicsBodies.peek(player).asleep, "input did not wake the player", name) ||
+		!check(registry.motions.peek(player).position.x > resting.x, "a woken player did not move", name))
+		return false;
+	return true;
+}
+
+int main()
+{
+	if (!run(BROADPHASE_TYPE::GRID, "grid") || !run(BROADPHASE_TYPE::SWEEP_AND_PRUNE, "sap"))
+		return EXIT_FAILURE;
+	printf("ok\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+// Cost of ECSRegistry::snapshot and restore against the number of entities, compared with
+// destroying and re-creating the same entities as WorldSystem::restart_game does. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "tiny_ecs_registry.hpp"
+
+// stlib
+#include <chrono>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double elapsed_us(Clock::time_point since)
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count() / 1000;
+}
+
+// Roughly what the stage creators add: two players, some blocks and texts, the rest projectiles
+static void populate(int n)
+{
+	for (int side = 1; side <= 2; side++)
+	{
+		Entity e;
+		Player player;
+		player.side = side;
+		registry.players.insert(e, player);
+		registry.inventories.emplace(e).items.push({ 0 });
+		registry.motions.emplace(e);
+		registry.renderRequests.emplace(e);
+		registry.meshPtrs.emplace(e, nullptr);
+		registry.gravities.emplace(e);
+	}
+	for (int i = 0; i < n - 2; i++)
+	{
+		Entity e;
+		Motion& motion = registry.motions.emplace(e);
+		motion.position = { (float)(i % 1200), (float)(i % 800) };
+		motion.velocity = { 500.f, 0.f };
+		registry.renderRequests.emplace(e);
+		registry.meshPtrs.emplace(e, nullptr);
+		if (i % 10 == 0) {
+			registry.blocks.emplace(e);
+		} else if (i % 50 == 1) {
+			registry.texts.insert(e, { "health + 3", motion.position, true });
+		} else {
+			registry.bullets.insert(e, { 1 + (i & 1) });
+			registry.colors.insert(e, { 0.6f, 1.0f, 0.6f });
+		}
+	}
+}
+
+static void destroy_all()
+{
+	while (registry.motions.entities.size() > 0)
+		registry.remove_all_components_of(registry.motions.entities.back());
+}
+
+int main()
+{
+	const int counts[] = { 100, 1000, 10000, 100000 };
+	const int REPEATS = 20;
+
+	Snapshot snapshot;
+	printf("%10s %12s %15s %15s %15s\n", "entities", "size (KB)", "snapshot (us)", "restore (us)", "rebuild (us)");
+	for (int n : counts)
+	{
+		populate(n);
+		registry.snapshot(snapshot); // grows the buffer once, the timed runs do not allocate
+
+		// Keep the best run to reduce noise
+		double snapshot_us = 1e12, restore_us = 1e12, rebuild_us = 1e12;
+		for (int r = 0; r < REPEATS; r++)
+		{
+			auto t = Clock::now();
+			registry.snapshot(snapshot);
+			snapshot_us = std::min(snapshot_us, elapsed_us(t));
+
+			// Move things around, so that restore has something to undo
+			for (Motion& m : registry.motions.components)
+				m.position += m.velocity;
+
+			t = Clock::now();
+			registry.restore(snapshot);
+			restore_us = std::min(restore_us, elapsed_us(t));
+
+			t = Clock::now();
+			destroy_all();
+			populate(n);
+			rebuild_us = std::min(rebuild_us, elapsed_us(t));
+		}
+		printf("%10d %12.1f %15.1f %15.1f %15.1f\n", n, snapshot.size() / 1024.0, snapshot_us, restore_us, rebuild_us);
+		destroy_all();
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+// Compares ComponentContainer::sort and sort_incremental with the previous sort, which rebuilt the component and
+// version vectors, on random and on nearly sorted containers of Motion ordered by x. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "tiny_ecs.hpp"
+#include "components.hpp"
+
+// stlib
+#include <chrono>
+#include <iterator>
+#include <random>
+#include <cstdio>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// The previous sort, kept here as the baseline: new vectors for the components and versions on every call.
+// The entities are sorted as in the current container, so that the comparison can look up components.
+class RebuildContainer : public ComponentContainer<Motion>
+{
+public:
+	template <class Compare>
+	void rebuild_sort(Compare comparisonFunction)
+	{
+		sort_entities(comparisonFunction);
+		std::vector<Motion> components_new; components_new.reserve(components.size());
+		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(components[*find_slot(e.index())]); });
+		components = std::move(components_new);
+		std::vector<unsigned int> versions_new; versions_new.reserve(versions.size());
+		for (Entity e : entities)
+			versions_new.push_back(versions[*find_slot(e.index())]);
+		versions = std::move(versions_new);
+		for (unsigned int i = 0; i < entities.size(); i++)
+			*find_slot(entities[i].index()) = i;
+	}
+};
+
+enum class Method { REBUILD, SORT, INCREMENTAL };
+
+// Sink so that the optimizer keeps the sort
+static volatile float sink;
+
+// The order is given by xs, which holds one x per entity in insertion order
+static double run(Method method, const std::vector<Entity>& all, const std::vector<float>& xs)
+{
+	RebuildContainer container;
+	for (size_t i = 0; i < all.size(); i++)
+		container.insert(all[i], Motion()).position.x = xs[i];
+
+	auto by_x = [&](Entity a, Entity b) { return container.peek(a).position.x < container.peek(b).position.x; };
+	auto t = Clock::now();
+	if (method == Method::REBUILD)
+		container.rebuild_sort(by_x);
+	else if (method == Method::SORT)
+		container.sort(by_x);
+	else
+		container.sort_incremental(by_x);
+	auto now = Clock::now();
+	sink = container.components.front().position.x;
+	return (double)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
+}
+
+// Repeat and keep the best run to reduce noise
+static double best(Method method, const std::vector<Entity>& all, const std::vector<float>& xs)
+{
+	double ms = 1e9;
+	for (int r = 0; r < 5; r++)
+		ms = std::min(ms, run(method, all, xs));
+	return ms;
+}
+
+int main()
+{
+	std::default_random_engine rng(427);
+	const int counts[] = { 1000, 10000, 100000 };
+
+	printf("%10s %14s %14s %14s %18s\n", "entities", "order", "rebuild (ms)", "sort (ms)", "incremental (ms)");
+	for (int n : counts)
+	{
+		std::vector<Entity> all(n);
+		std::uniform_real_distribution<float> positions(0.f, 1280.f);
+		std::vector<float> random_xs(n);
+		for (float& x : random_xs)
+			x = positions(rng);
+
+		// sorted by the last frame, then 1% of the bodies moved a few pixels
+		std::vector<float> nearly_sorted_xs(n);
+		for (int i = 0; i < n; i++)
+			nearly_sorted_xs[i] = 1280.f * i / n;
+		for (int i = 0; i < n / 100; i++)
+			nearly_sorted_xs[rng() % n] += positions(rng) / 256.f;
+
+		// the insertion sort of a random container is quadratic, only the small one is measured
+		printf("%10d %14s %14.3f %14.3f", n, "random", best(Method::REBUILD, all, random_xs), best(Method::SORT, all, random_xs));
+		if (n <= 10000)
+			printf(" %18.3f\n", best(Method::INCREMENTAL, all, random_xs));
+		else
+			printf(" %18s\n", "-");
+		printf("%10d %14s %14.3f %14.3f %18.3f\n", n, "nearly sorted", best(Method::REBUILD, all, nearly_sorted_xs),
+			best(Method::SORT, all, nearly_sorted_xs), best(Method::INCREMENTAL, all, nearly_sorted_xs));
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+// Self-check of ComponentContainer::sort and sort_incremental:
+// - random and nearly sorted containers end up ordered by the key, and sort_incremental keeps equal keys in order
+// - after sorting, every entity still finds its own component and version, through entities[i] and through peek()
+// - the container keeps working afterwards: removals and inserts leave the components matched to their entities
+// Fails with a non-zero exit code. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <random>
+#include <string>
+#include <cstdio>
+
+// Not trivially copyable, so that the permutation has to move the components
+struct Keyed
+{
+	int key = 0;
+	unsigned int owner = 0;
+	std::string name;
+};
+
+static bool check(bool condition, const char* what, const char* method, const char* order)
+{
+	if (!condition)
+		printf("%s, %s of a %s container\n", what, method, order);
+	return condition;
+}
+
+// The version each entity's component should have, by entity index
+static std::vector<unsigned int> expected_versions;
+
+static void insert(ComponentContainer<Keyed>& c, int key)
+{
+	ChangeTick::advance(); // every component gets a version of its own
+	Entity e;
+	Keyed& k = c.emplace(e);
+	k.key = key;
+	k.owner = e.index();
+	k.name = std::to_string(e.index());
+	if (e.index() >= expected_versions.size())
+		expected_versions.resize(e.index() + 1);
+	expected_versions[e.index()] = ChangeTick::current();
+}
+
+// Whether components, versions and sparse slots line up with entities
+static bool lined_up(ComponentContainer<Keyed>& c, const char* method, const char* order)
+{
+	if (!check(c.components.size() == c.entities.size() && c.versions.size() == c.entities.size(),
+			"the arrays differ in size", method, order))
+		return false;
+	for (unsigned int i = 0; i < c.entities.size(); i++)
+	{
+		Entity e = c.entities[i];
+		if (!check(c.components[i].owner == e.index() && c.components[i].name == std::to_string(e.index()),
+				"a component is not at the position of its entity", method, order) ||
+			!check(c.versions[i] == expected_versions[e.index()], "a version is not at the position of its entity", method, order) ||
+			!check(c.has(e) && &c.peek(e) == &c.components[i], "a sparse slot points at the wrong position", method, order))
+			return false;
+	}
+	return true;
+}
+
+// The position of each entity before sorting, by entity index
+static std::vector<unsigned int> positions_before(ComponentContainer<Keyed>& c)
+{
+	std::vector<unsigned int> positions(expected_versions.size());
+	for (unsigned int i = 0; i < c.entities.size(); i++)
+		positions[c.entities[i].index()] = i;
+	return positions;
+}
+
+// Stable sorts also keep equal keys in their order before the sort
+static bool sorted(ComponentContainer<Keyed>& c, bool stable, const std::vector<unsigned int>& before, const char* method, const char* order)
+{
+	for (unsigned int i = 1; i < c.components.size(); i++)
+	{
+		const Keyed& a = c.components[i - 1];
+		const Keyed& b = c.components[i];
+		if (!check(a.key <= b.key, "the container is not sorted", method, order) ||
+			(stable && !check(a.key < b.key || before[a.owner] < before[b.owner], "equal keys changed order", method, order)))
+			return false;
+	}
+	return true;
+}
+
+static bool run(bool incremental, bool nearly_sorted, unsigned int n)
+{
+	const char* method = incremental ? "sort_incremental" : "sort";
+	const char* order = nearly_sorted ? "nearly sorted" : "random";
+	std::default_random_engine rng(n);
+	std::uniform_int_distribution<int> keys(0, (int)n / 4 + 1); // with repeated keys
+
+	ComponentContainer<Keyed> c;
+	for (unsigned int i = 0; i < n; i++)
+		insert(c, nearly_sorted ? (int)i : keys(rng));
+	// holes, so that positions and entity indices no longer agree
+	for (unsigned int i = 0; i < n / 8; i++)
+		c.remove(c.entities[rng() % c.entities.size()]);
+	if (nearly_sorted) {
+		c.sort([&](Entity a, Entity b) { return c.peek(a).key < c.peek(b).key; });
+		// a few bodies move a little, as between two frames
+		for (unsigned int i = 0; i < n / 50; i++) {
+			unsigned int p = rng() % c.components.size();
+			c.components[p].key += (int)(rng() % 7) - 3;
+		}
+	}
+
+	auto by_key = [&](Entity a, Entity b) { return c.peek(a).key < c.peek(b).key; };
+	// the second sort finds the container sorted already
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::vector<unsigned int> before = positions_before(c);
+		if (incremental)
+			c.sort_incremental(by_key);
+		else
+			c.sort(by_key);
+		if (!lined_up(c, method, order) || !sorted(c, incremental, before, method, order))
+			return false;
+	}
+
+	// removals move the last component into the hole, inserts append; both need the sparse slots
+	for (unsigned int i = 0; i < n / 4 && !c.entities.empty(); i++)
+		c.remove(c.entities[rng() % c.entities.size()]);
+	for (unsigned int i = 0; i < n / 4; i++)
+		insert(c, keys(rng));
+	return lined_up(c, method, order);
+}
+
+int main()
+{
+	const unsigned int sizes[] = { 0, 1, 2, 3, 17, 1000, 20000 };
+	for (unsigned int n : sizes)
+		for (int incremental = 0; incremental < 2; incremental++)
+			for (int nearly_sorted = 0; nearly_sorted < 2; nearly_sorted++)
+				if (!run(incremental != 0, nearly_sorted != 0, n))
+					return EXIT_FAILURE;
+
+	printf("ok\n");
+	return EXIT_SUCCESS;
+}
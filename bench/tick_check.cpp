@@ -0,0 +1,96 @@
+// Self-check of the fixed 120 Hz simulation loop of main() and its render interpolation:
+// - ten seconds of frames give 1200 ticks at any frame rate from 20 to 1000 fps, and alpha stays in 0..1
+// - after a one second hitch only MAX_TICKS_PER_FRAME ticks are run and the backlog is dropped
+// - a body moving at a constant speed is drawn exactly one tick behind the time of the frame at every frame rate,
+//   which is smooth, and a teleported or newly created body is drawn where it is
+// Fails with a non-zero exit code. Build with -DRB_BUILD_BENCHMARKS=ON.
+
+// internal
+#include "fixed_timestep.hpp"
+
+// stlib
+#include <cmath>
+#include <cstdio>
+
+const float TICK_MS = 1000.f / 120.f;
+const int MAX_TICKS_PER_FRAME = 8;
+const float SPEED = 300.f; // px/s
+
+static bool check(bool condition, const char* what, float frame_ms)
+{
+	if (!condition)
+		printf("%s, with %.3f ms frames\n", what, frame_ms);
+	return condition;
+}
+
+// Runs ten seconds of frames of frame_ms through the loop with one moving body
+static bool run(float frame_ms)
+{
+	FixedTimestep timestep(TICK_MS, MAX_TICKS_PER_FRAME);
+	MotionHistory history;
+	ComponentContainer<Motion> motions;
+	Entity body;
+	motions.emplace(body).velocity = { SPEED, 0.f };
+
+	int frames = (int)std::lround(10000.f / frame_ms);
+	int ticks = 0;
+	double elapsed_ms = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		elapsed_ms += frame_ms;
+		int frame_ticks = timestep.advance(frame_ms);
+		for (int tick = 0; tick < frame_ticks; tick++)
+		{
+			history.store(motions);
+			ticks++;
+			// the position after `ticks` ticks, computed directly so that no float error piles up
+			motions.components[0].position.x = SPEED * ticks * TICK_MS / 1000.f;
+		}
+		float alpha = timestep.alpha();
+		if (!check(alpha >= 0.f && alpha < 1.f, "alpha left 0..1", frame_ms))
+			return false;
+
+		// once the first tick ran, the frame shows the state of one tick ago
+		if (ticks > 0) {
+			float drawn = history.interpolated(body, motions.components[0], alpha).position.x;
+			float expected = SPEED * (float)(elapsed_ms - TICK_MS) / 1000.f;
+			if (!check(std::abs(drawn - expected) < 0.01f, "the body is not drawn one tick behind the frame", frame_ms))
+				return false;
+		}
+	}
+	// the tick boundaries may fall on either side of the last frame by float rounding
+	int expected_ticks = (int)(frames * frame_ms / TICK_MS);
+	return check(std::abs(ticks - expected_ticks) <= 1, "the tick count depends on the frame rate", frame_ms);
+}
+
+int main()
+{
+	const float frame_times[] = { 1.f, 1000.f / 240.f, 1000.f / 144.f, TICK_MS, 1000.f / 60.f, 1000.f / 30.f, 50.f };
+	for (float frame_ms : frame_times)
+		if (!run(frame_ms))
+			return EXIT_FAILURE;
+
+	// a hitch runs at most MAX_TICKS_PER_FRAME ticks, then the next frame is back to normal
+	FixedTimestep timestep(TICK_MS, MAX_TICKS_PER_FRAME);
+	if (!check(timestep.advance(1000.f) == MAX_TICKS_PER_FRAME && timestep.alpha() <= 1.f, "a hitch ran the whole backlog", 1000.f) ||
+		!check(timestep.advance(1000.f / 60.f) <= 3, "the backlog of a hitch was kept", 1000.f / 60.f))
+		return EXIT_FAILURE;
+
+	// teleported and newly created bodies are not blended
+	MotionHistory history;
+	ComponentContainer<Motion> motions;
+	Entity portal_user;
+	motions.emplace(portal_user).position = { 50.f, 300.f };
+	history.store(motions);
+	motions.components[0].position = { 1200.f, 300.f };
+	Entity created;
+	motions.emplace(created).position = { 600.f, 300.f };
+	if (!check(history.interpolated(portal_user, motions.components[0], 0.5f).position == motions.components[0].position,
+			"a teleported body was blended", TICK_MS) ||
+		!check(history.interpolated(created, motions.components[1], 0.5f).position == motions.components[1].position,
+			"a new body was blended with an older one", TICK_MS))
+		return EXIT_FAILURE;
+
+	printf("ok\n");
+	return EXIT_SUCCESS;
+}
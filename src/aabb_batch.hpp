@@ -0,0 +1,202 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Tests one box against several candidates at once. The candidates are stored as separate arrays (SoA) so that
+// a batch is a single load per coordinate. The instruction set is picked at compile time: AVX2 (8 lanes, build
+// with RB_ENABLE_AVX2), SSE2 (4 lanes, any x86-64 build) or a scalar loop elsewhere, e.g. on ARM Macs.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RB_AABB_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RB_AABB_SSE2
+#endif
+
+// Axis-aligned bounds of a body, the same box that collides() tests
+struct BroadphaseBox
+{
+	vec2 min;
+	vec2 max;
+	// pairs of two boxes that are not dynamic (see BODY_TYPE) are never reported
+	bool dynamic = true;
+	// nor pairs of two resting boxes (static or asleep, see PhysicsBody)
+	bool resting = false;
+	// nor pairs where the mask of one box does not contain the layer bit of the other (see COLLISION_LAYER)
+	unsigned int layer_bit = 1;
+	unsigned int mask = ~0u;
+};
+
+// Whether the broadphase should test a and b at all, done before the overlap test
+inline bool may_collide(const BroadphaseBox& a, const BroadphaseBox& b)
+{
+	return (a.dynamic || b.dynamic) && !(a.resting && b.resting) && (a.mask & b.layer_bit);
+}
+
+enum : unsigned int {
+#if defined(RB_AABB_AVX2)
+	AABB_BATCH_WIDTH = 8
+#else
+	AABB_BATCH_WIDTH = 4
+#endif
+};
+
+// Bit k is set for candidate first + k
+struct AabbBatchResult
+{
+	unsigned int hits;
+	// of the hits, the ones that overlap less on x than on y: a left/right collision, see collides()
+	unsigned int x_axis;
+};
+
+// Boxes by coordinate, followed by AABB_BATCH_WIDTH - 1 empty boxes so that a batch never reads past the end
+struct AabbSoA
+{
+	std::vector<float> min_x;
+	std::vector<float> min_y;
+	std::vector<float> max_x;
+	std::vector<float> max_y;
+
+	size_t size() const { return count; }
+
+	void resize(size_t n)
+	{
+		count = n;
+		size_t padded = n + AABB_BATCH_WIDTH - 1;
+		min_x.resize(padded);
+		min_y.resize(padded);
+		max_x.resize(padded);
+		max_y.resize(padded);
+		// min > max never overlaps anything
+		for (size_t i = n; i < padded; i++)
+		{
+			min_x[i] = min_y[i] = std::numeric_limits<float>::max();
+			max_x[i] = max_y[i] = std::numeric_limits<float>::lowest();
+		}
+	}
+
+	void set(size_t i, const BroadphaseBox& box)
+	{
+		min_x[i] = box.min.x;
+		min_y[i] = box.min.y;
+		max_x[i] = box.max.x;
+		max_y[i] = box.max.y;
+	}
+
+private:
+	size_t count = 0;
+};
+
+// Strict overlap as in collides(), boxes that only touch do not overlap. x_axis is only set on a hit.
+inline bool aabb_overlap(const BroadphaseBox& a, const BroadphaseBox& b, bool& x_axis)
+{
+	if (!(a.min.x < b.max.x && b.min.x < a.max.x && a.min.y < b.max.y && b.min.y < a.max.y))
+		return false;
+	// the same expressions as collides(), so that both pick the same axis
+	float x_overlap = std::min(a.max.x, b.max.x) - std::max(a.min.x, b.min.x);
+	float y_overlap = std::min(a.max.y, b.max.y) - std::max(a.min.y, b.min.y);
+	x_axis = x_overlap < y_overlap;
+	return true;
+}
+
+// Swept test for a box a that moves by displacement while b rests (for two moving boxes, pass the displacement of
+// a relative to b). Finds the first time t in [0, 1) of the move at which they overlap, with the same strict
+// overlap as aabb_overlap, and the axis they overlap on last, which is the side a hits.
+inline bool aabb_sweep(const BroadphaseBox& a, vec2 displacement, const BroadphaseBox& b, float& t, bool& x_axis)
+{
+	if (aabb_overlap(a, b, x_axis)) {
+		t = 0.f;
+		return true;
+	}
+
+	float t_enter = 0.f, t_exit = 1.f;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (displacement[axis] == 0.f)
+		{
+			// never overlaps on this axis
+			if (a.min[axis] >= b.max[axis] || b.min[axis] >= a.max[axis])
+				return false;
+			continue;
+		}
+		float t0 = (b.min[axis] - a.max[axis]) / displacement[axis];
+		float t1 = (b.max[axis] - a.min[axis]) / displacement[axis];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > t_enter) {
+			t_enter = t0;
+			x_axis = axis == 0;
+		}
+		t_exit = std::min(t_exit, t1);
+		if (t_enter >= t_exit)
+			return false;
+	}
+	t = t_enter;
+	return true;
+}
+
+// The reference for aabb_overlap_batch, one candidate at a time
+inline AabbBatchResult aabb_overlap_batch_scalar(const BroadphaseBox& a, const AabbSoA& soa, size_t first)
+{
+	AabbBatchResult result = { 0, 0 };
+	for (unsigned int lane = 0; lane < AABB_BATCH_WIDTH; lane++)
+	{
+		size_t k = first + lane;
+		BroadphaseBox b;
+		b.min = { soa.min_x[k], soa.min_y[k] };
+		b.max = { soa.max_x[k], soa.max_y[k] };
+		bool x_axis;
+		if (aabb_overlap(a, b, x_axis))
+		{
+			result.hits |= 1u << lane;
+			result.x_axis |= (unsigned int)x_axis << lane;
+		}
+	}
+	return result;
+}
+
+// Tests a against the candidates first .. first + AABB_BATCH_WIDTH - 1, which may include the padding
+inline AabbBatchResult aabb_overlap_batch(const BroadphaseBox& a, const AabbSoA& soa, size_t first)
+{
+#if defined(RB_AABB_AVX2)
+	__m256 b_min_x = _mm256_loadu_ps(&soa.min_x[first]);
+	__m256 b_min_y = _mm256_loadu_ps(&soa.min_y[first]);
+	__m256 b_max_x = _mm256_loadu_ps(&soa.max_x[first]);
+	__m256 b_max_y = _mm256_loadu_ps(&soa.max_y[first]);
+	__m256 a_min_x = _mm256_set1_ps(a.min.x);
+	__m256 a_min_y = _mm256_set1_ps(a.min.y);
+	__m256 a_max_x = _mm256_set1_ps(a.max.x);
+	__m256 a_max_y = _mm256_set1_ps(a.max.y);
+
+	__m256 hit = _mm256_and_ps(
+		_mm256_and_ps(_mm256_cmp_ps(a_min_x, b_max_x, _CMP_LT_OQ), _mm256_cmp_ps(b_min_x, a_max_x, _CMP_LT_OQ)),
+		_mm256_and_ps(_mm256_cmp_ps(a_min_y, b_max_y, _CMP_LT_OQ), _mm256_cmp_ps(b_min_y, a_max_y, _CMP_LT_OQ)));
+	__m256 x_overlap = _mm256_sub_ps(_mm256_min_ps(a_max_x, b_max_x), _mm256_max_ps(a_min_x, b_min_x));
+	__m256 y_overlap = _mm256_sub_ps(_mm256_min_ps(a_max_y, b_max_y), _mm256_max_ps(a_min_y, b_min_y));
+	__m256 x_axis = _mm256_and_ps(hit, _mm256_cmp_ps(x_overlap, y_overlap, _CMP_LT_OQ));
+	return { (unsigned int)_mm256_movemask_ps(hit), (unsigned int)_mm256_movemask_ps(x_axis) };
+#elif defined(RB_AABB_SSE2)
+	__m128 b_min_x = _mm_loadu_ps(&soa.min_x[first]);
+	__m128 b_min_y = _mm_loadu_ps(&soa.min_y[first]);
+	__m128 b_max_x = _mm_loadu_ps(&soa.max_x[first]);
+	__m128 b_max_y = _mm_loadu_ps(&soa.max_y[first]);
+	__m128 a_min_x = _mm_set1_ps(a.min.x);
+	__m128 a_min_y = _mm_set1_ps(a.min.y);
+	__m128 a_max_x = _mm_set1_ps(a.max.x);
+	__m128 a_max_y = _mm_set1_ps(a.max.y);
+
+	__m128 hit = _mm_and_ps(
+		_mm_and_ps(_mm_cmplt_ps(a_min_x, b_max_x), _mm_cmplt_ps(b_min_x, a_max_x)),
+		_mm_and_ps(_mm_cmplt_ps(a_min_y, b_max_y), _mm_cmplt_ps(b_min_y, a_max_y)));
+	__m128 x_overlap = _mm_sub_ps(_mm_min_ps(a_max_x, b_max_x), _mm_max_ps(a_min_x, b_min_x));
+	__m128 y_overlap = _mm_sub_ps(_mm_min_ps(a_max_y, b_max_y), _mm_max_ps(a_min_y, b_min_y));
+	__m128 x_axis = _mm_and_ps(hit, _mm_cmplt_ps(x_overlap, y_overlap));
+	return { (unsigned int)_mm_movemask_ps(hit), (unsigned int)_mm_movemask_ps(x_axis) };
+#else
+	return aabb_overlap_batch_scalar(a, soa, first);
+#endif
+}
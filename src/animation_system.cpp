@@ -2,13 +2,7 @@
 #include "tiny_ecs_registry.hpp"
 
 void AnimationSystem::step(float elapsed_ms) {
-    for (auto entity : registry.animations.entities) {
-        if (!registry.players.has(entity)) continue;
-        
-        auto& player = registry.players.get(entity);
-        auto& animation = registry.animations.get(entity);
-        auto& render_request = registry.renderRequests.get(entity);
-
+    registry.view<AnimationFrame, Player, RenderRequest>().each([&](Entity, AnimationFrame& animation, Player& player, RenderRequest& render_request) {
         if (player.is_moving) {
             animation.frame_time += elapsed_ms;
             if (animation.frame_time >= FRAME_TIME) {
@@ -22,5 +16,5 @@ void AnimationSystem::step(float elapsed_ms) {
             animation.frame_time = 0.f;
             render_request.used_texture = animation.frames[0];
         }
-    }
+    });
 } 
\ No newline at end of file
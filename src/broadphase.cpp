@@ -0,0 +1,210 @@
+// internal
+#include "broadphase.hpp"
+
+// stlib
+#include <algorithm>
+
+BroadphaseBox bounding_box(const Motion& motion)
+{
+	// abs is to avoid negative scale due to the facing direction.
+	vec2 half = abs(motion.scale) / 2.f;
+	return { motion.position - half, motion.position + half };
+}
+
+UniformGrid::UniformGrid(vec2 arena_size, float cell_size) : cell_size(cell_size)
+{
+	columns = std::max(1, (int)ceil(arena_size.x / cell_size));
+	rows = std::max(1, (int)ceil(arena_size.y / cell_size));
+}
+
+ivec2 UniformGrid::cell_of(vec2 p) const
+{
+	// compare as floats first, far away or non-finite positions would overflow the int conversion
+	float x = std::min(std::max(p.x / cell_size, 0.f), (float)(columns - 1));
+	float y = std::min(std::max(p.y / cell_size, 0.f), (float)(rows - 1));
+	return { (int)x, (int)y };
+}
+
+std::unique_ptr<Broadphase> make_broadphase(BROADPHASE_TYPE type)
+{
+	if (type == BROADPHASE_TYPE::SWEEP_AND_PRUNE)
+		return std::unique_ptr<Broadphase>(new SweepAndPrune());
+	return std::unique_ptr<Broadphase>(new UniformGrid());
+}
+
+void UniformGrid::find_pairs(const std::vector<BroadphaseBox>& boxes, std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+	const unsigned int num_cells = (unsigned int)(columns * rows);
+
+	// Count the bodies per cell, then place them with a prefix sum (counting sort)
+	cell_start.assign(num_cells + 1, 0);
+	ranges.resize(boxes.size());
+	size_t num_items = 0;
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		ivec2 lo = cell_of(boxes[i].min);
+		ivec2 hi = cell_of(boxes[i].max);
+		ranges[i] = { lo.x, lo.y, hi.x, hi.y };
+		for (int y = lo.y; y <= hi.y; y++)
+			for (int x = lo.x; x <= hi.x; x++)
+				cell_start[y * columns + x + 1]++;
+		num_items += (size_t)(hi.x - lo.x + 1) * (hi.y - lo.y + 1);
+	}
+	for (unsigned int c = 0; c < num_cells; c++)
+		cell_start[c + 1] += cell_start[c];
+
+	cell_items.resize(num_items);
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		const CellRange& r = ranges[i];
+		for (int y = r.y0; y <= r.y1; y++)
+			for (int x = r.x0; x <= r.x1; x++)
+				cell_items[cell_start[y * columns + x]++] = (unsigned int)i;
+	}
+	// The fill advanced every start to the next cell's start, shift back
+	for (unsigned int c = num_cells; c > 0; c--)
+		cell_start[c] = cell_start[c - 1];
+	cell_start[0] = 0;
+
+	for (unsigned int c = 0; c < num_cells; c++)
+	{
+		ivec2 cell = { (int)(c % columns), (int)(c / columns) };
+		for (unsigned int a = cell_start[c]; a < cell_start[c + 1]; a++)
+		{
+			unsigned int i = cell_items[a];
+			for (unsigned int b = a + 1; b < cell_start[c + 1]; b++)
+			{
+				unsigned int j = cell_items[b];
+				bool x_axis;
+				if (!may_collide(boxes[i], boxes[j]) || !aabb_overlap(boxes[i], boxes[j], x_axis))
+					continue;
+				// Two bodies can share several cells, report the pair only in the cell of the overlap's min corner
+				if (cell_of(max(boxes[i].min, boxes[j].min)) != cell)
+					continue;
+				pairs.push_back({ std::min(i, j), std::max(i, j), x_axis });
+			}
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end());
+}
+
+void UniformGrid::query(const std::vector<BroadphaseBox>& boxes, const BroadphaseBox& box, std::vector<unsigned int>& found) const
+{
+	found.clear();
+	if (cell_start.empty())
+		return;
+
+	ivec2 lo = cell_of(box.min);
+	ivec2 hi = cell_of(box.max);
+	for (int y = lo.y; y <= hi.y; y++)
+	{
+		for (int x = lo.x; x <= hi.x; x++)
+		{
+			unsigned int c = y * columns + x;
+			for (unsigned int a = cell_start[c]; a < cell_start[c + 1]; a++)
+			{
+				unsigned int i = cell_items[a];
+				bool x_axis;
+				if (!(box.mask & boxes[i].layer_bit) || !aabb_overlap(box, boxes[i], x_axis))
+					continue;
+				// as for pairs, a box in several of the cells is only reported in the cell of the overlap's min corner
+				if (cell_of(max(box.min, boxes[i].min)) != ivec2(x, y))
+					continue;
+				found.push_back(i);
+			}
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+}
+
+// Boxes wider than this are not bounded by SweepAndPrune::max_width, so that a background does not make every query scan
+const float WIDE_BOX = 256.f;
+
+void SweepAndPrune::find_pairs(const std::vector<BroadphaseBox>& boxes, std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+	const unsigned int n = (unsigned int)boxes.size();
+
+	// Bodies removed since the last frame leave the list, new ones are appended and sorted in below.
+	// A box that moved to another position in the vector is simply out of place and also fixed by the sort.
+	if (order.size() > n)
+		order.erase(std::remove_if(order.begin(), order.end(), [n](const Endpoint& e) { return e.box >= n; }), order.end());
+	unsigned int appended = n - (unsigned int)order.size();
+	for (unsigned int i = (unsigned int)order.size(); i < n; i++)
+		order.push_back({ 0.f, i });
+
+	for (Endpoint& e : order)
+		e.min_x = boxes[e.box].min.x;
+	if (appended > n / 4)
+	{
+		// First frame or a new stage, nothing to be coherent with
+		std::sort(order.begin(), order.end(), [](const Endpoint& a, const Endpoint& b) { return a.min_x < b.min_x; });
+	}
+	else
+	{
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			Endpoint e = order[i];
+			size_t j = i;
+			for (; j > 0 && order[j - 1].min_x > e.min_x; j--)
+				order[j] = order[j - 1];
+			order[j] = e;
+		}
+	}
+
+	sorted.resize(order.size());
+	max_width = 0.f;
+	wide.clear();
+	for (size_t k = 0; k < order.size(); k++)
+	{
+		const BroadphaseBox& box = boxes[order[k].box];
+		sorted.set(k, box);
+		if (box.max.x - box.min.x > WIDE_BOX)
+			wide.push_back(order[k].box);
+		else
+			max_width = std::max(max_width, box.max.x - box.min.x);
+	}
+
+	for (size_t a = 0; a < order.size(); a++)
+	{
+		const BroadphaseBox& box_a = boxes[order[a].box];
+		// Candidates that start right of box_a cannot overlap it, so they only waste lanes of the last batch
+		for (size_t b = a + 1; b < order.size() && order[b].min_x < box_a.max.x; b += AABB_BATCH_WIDTH)
+		{
+			AabbBatchResult result = aabb_overlap_batch(box_a, sorted, b);
+			for (unsigned int lane = 0; result.hits >> lane; lane++)
+			{
+				if (!(result.hits & (1u << lane)) || !may_collide(box_a, boxes[order[b + lane].box]))
+					continue;
+				unsigned int i = order[a].box, j = order[b + lane].box;
+				pairs.push_back({ std::min(i, j), std::max(i, j), ((result.x_axis >> lane) & 1) != 0 });
+			}
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end());
+}
+
+void SweepAndPrune::query(const std::vector<BroadphaseBox>& boxes, const BroadphaseBox& box, std::vector<unsigned int>& found) const
+{
+	found.clear();
+	bool x_axis;
+	for (unsigned int i : wide)
+		if ((box.mask & boxes[i].layer_bit) && aabb_overlap(box, boxes[i], x_axis))
+			found.push_back(i);
+
+	// The narrow boxes that overlap box start at most max_width left of it, and before its right edge
+	auto first = std::lower_bound(order.begin(), order.end(), box.min.x - max_width,
+		[](const Endpoint& e, float min_x) { return e.min_x < min_x; });
+	for (auto e = first; e != order.end() && e->min_x < box.max.x; ++e)
+	{
+		const BroadphaseBox& candidate = boxes[e->box];
+		if (candidate.max.x - candidate.min.x <= WIDE_BOX && (box.mask & candidate.layer_bit) && aabb_overlap(box, candidate, x_axis))
+			found.push_back(e->box);
+	}
+
+	std::sort(found.begin(), found.end());
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "common.hpp"
+#include "components.hpp"
+#include "aabb_batch.hpp"
+
+#include <memory>
+#include <vector>
+
+BroadphaseBox bounding_box(const Motion& motion);
+
+// Pair of overlapping bodies, as indices first < second into the boxes given to the broadphase
+struct BroadphasePair
+{
+	unsigned int first;
+	unsigned int second;
+	// the boxes overlap less on x than on y, i.e. a left/right collision, see collides()
+	bool x_axis;
+
+	bool operator<(const BroadphasePair& other) const
+	{
+		return first < other.first || (first == other.first && second < other.second);
+	}
+};
+
+// Finds the candidate pairs for the narrowphase in PhysicsSystem::step. Implementations may keep state between
+// frames, keyed by the position of a box in the vector, so they should be given the boxes in the same order every frame.
+class Broadphase
+{
+public:
+	virtual ~Broadphase() = default;
+
+	// Fills pairs with all pairs of overlapping boxes that may_collide(), each pair once, sorted by (i, j) so that the
+	// narrowphase visits them in the same order as a loop over all pairs would
+	virtual void find_pairs(const std::vector<BroadphaseBox>& boxes, std::vector<BroadphasePair>& pairs) = 0;
+
+	// Fills found with the boxes of the last find_pairs that overlap box and whose layer bit is in box.mask, each once
+	// and in ascending order. boxes has to be the vector given to that find_pairs. Used by the PhysicsSystem queries.
+	virtual void query(const std::vector<BroadphaseBox>& boxes, const BroadphaseBox& box, std::vector<unsigned int>& found) const = 0;
+};
+
+enum class BROADPHASE_TYPE {
+	GRID = 0,
+	SWEEP_AND_PRUNE = GRID + 1,
+	BROADPHASE_COUNT = SWEEP_AND_PRUNE + 1
+};
+
+std::unique_ptr<Broadphase> make_broadphase(BROADPHASE_TYPE type);
+
+// Uniform grid broadphase over the arena. Each body is registered in every cell its box covers and only
+// bodies that share a cell are tested against each other. Bodies outside the arena are clamped into the border cells.
+// All buffers are kept between frames, so after warm-up finding pairs does not allocate.
+class UniformGrid : public Broadphase
+{
+public:
+	UniformGrid(vec2 arena_size = { window_width_px, window_height_px }, float cell_size = 64.f);
+
+	void find_pairs(const std::vector<BroadphaseBox>& boxes, std::vector<BroadphasePair>& pairs) override;
+	void query(const std::vector<BroadphaseBox>& boxes, const BroadphaseBox& box, std::vector<unsigned int>& found) const override;
+
+private:
+	float cell_size;
+	int columns;
+	int rows;
+
+	// The bodies of cell c are cell_items[cell_start[c] .. cell_start[c + 1]), filled by a counting sort
+	std::vector<unsigned int> cell_start;
+	std::vector<unsigned int> cell_items;
+	// The cells covered by each body
+	struct CellRange { int x0, y0, x1, y1; };
+	std::vector<CellRange> ranges;
+
+	ivec2 cell_of(vec2 p) const;
+};
+
+// Sweep and prune on the x axis. The bodies sorted by their left edge are kept between frames and re-sorted
+// with an insertion sort, which is close to linear as most bodies only move a few pixels per frame.
+// The sweep then only tests a body against the ones that start before its right edge.
+class SweepAndPrune : public Broadphase
+{
+public:
+	void find_pairs(const std::vector<BroadphaseBox>& boxes, std::vector<BroadphasePair>& pairs) override;
+	void query(const std::vector<BroadphaseBox>& boxes, const BroadphaseBox& box, std::vector<unsigned int>& found) const override;
+
+private:
+	struct Endpoint
+	{
+		float min_x;
+		unsigned int box;
+	};
+	// Sorted by min_x after each find_pairs
+	std::vector<Endpoint> order;
+	// The boxes in that order, for the batched overlap test of the sweep
+	AabbSoA sorted;
+	// For queries: the widest box, except for the few very wide ones (backgrounds), which are listed instead
+	float max_width = 0.f;
+	std::vector<unsigned int> wide;
+};
@@ -1,7 +1,6 @@
 #pragma once
 #include "common.hpp"
 #include <vector>
-#include <queue>
 #include <unordered_map>
 #include "../ext/stb_image/stb_image.h"
 
@@ -10,7 +9,7 @@ struct Item
     int id; // 0 = health potion, 1 = grenade, 2 = laser gun        
 };
 
-// Player component
+// Player component, the state read every frame. The inventory is kept apart in Inventory.
 struct Player
 {
 	int side; // side = 1 for blue, side = 2 for red
@@ -20,10 +19,47 @@ struct Player
 	bool is_moving = false;
 	float jump_accel = -600.f;
 	float lr_accel = 1200.f;
-	
-	std::queue<Item> items;
 };
 
+// Fixed-capacity FIFO of items stored inline, with the part of the std::queue interface the game uses
+struct ItemRing
+{
+	enum : unsigned int { CAPACITY = 3 }; // a player carries at most 3 items
+
+	Item slots[CAPACITY];
+	unsigned int head = 0;
+	unsigned int count = 0;
+
+	bool empty() const { return count == 0; }
+	bool full() const { return count == CAPACITY; }
+	size_t size() const { return count; }
+
+	Item& front() {
+		assert(!empty());
+		return slots[head];
+	}
+
+	void pop() {
+		assert(!empty());
+		head = (head + 1) % CAPACITY;
+		count--;
+	}
+
+	void push(Item item) {
+		assert(!full() && "Pop an item first");
+		slots[(head + count) % CAPACITY] = item;
+		count++;
+	}
+};
+
+// The items a player picked up, used only on pick up and when an item key is pressed
+struct Inventory
+{
+	ItemRing items;
+};
+static_assert(std::is_trivially_copyable<Player>::value && std::is_trivially_copyable<Inventory>::value,
+	"Player and Inventory are copied as memory blocks, e.g. by registry snapshots");
+
 struct GunTimer {
 	float counter_ms = 600;
 };
@@ -40,9 +76,8 @@ struct Grenade {
 	int side; // side = 1 for blue, side = 2 for red
 };
 
+// Only drawn, the players in reach are hit when it is created (see WorldSystem::explode)
 struct Explosion {
-	bool damagable1 = true;
-	bool damagable2 = true;
 };
 
 // Weapon component
@@ -66,6 +101,53 @@ struct Motion {
 	float angle = 0.f;
 };
 
+// How PhysicsSystem treats a body with a Motion: static bodies (ground, backgrounds, ...) are never moved,
+// kinematic ones only follow their velocity (moving platforms) and dynamic ones are players and projectiles.
+// Only pairs with at least one dynamic body are tested for collisions.
+enum class BODY_TYPE {
+	STATIC = 0,
+	KINEMATIC = STATIC + 1,
+	DYNAMIC = KINEMATIC + 1
+};
+
+// What a body is for collision filtering, PhysicsSystem decides which layers collide with each other
+// (see PhysicsSystem::set_layers_collide). Pairs of layers that do not collide never reach the narrowphase.
+enum class COLLISION_LAYER {
+	DEFAULT = 0, // collides with all layers but NONE
+	NONE = DEFAULT + 1, // scenery, guns, ...: collides with nothing
+	PLAYER = NONE + 1,
+	BLOCK = PLAYER + 1,
+	BULLET = BLOCK + 1,
+	GRENADE = BULLET + 1,
+	PORTAL = GRENADE + 1,
+	ITEM = PORTAL + 1,
+	LAYER_COUNT = ITEM + 1
+};
+const int collision_layer_count = (int)COLLISION_LAYER::LAYER_COUNT;
+
+// Layers are combined into masks, e.g. for the PhysicsSystem queries
+inline unsigned int layer_bit(COLLISION_LAYER layer) { return 1u << (int)layer; }
+
+// Bullets and grenades: fast and small enough to pass through a thin block or a player within one step, so
+// PhysicsSystem tests the box they swept during the step and moves them back to the first impact
+struct FastMover {
+};
+
+// Bodies without one are kinematic and on the DEFAULT layer
+struct PhysicsBody {
+	BODY_TYPE type = BODY_TYPE::KINEMATIC;
+	COLLISION_LAYER layer = COLLISION_LAYER::DEFAULT;
+	// A non-static body that kept still for PhysicsSystem::set_sleep_ticks ticks falls asleep: it is not integrated
+	// and not tested against static or other sleeping bodies. It wakes when its Motion or Gravity is changed
+	// (input, impulses, teleports) or when an awake body touches it (e.g. the moving block it stands on).
+	bool asleep = false;
+	unsigned int still_ticks = 0;
+	// the values at the start of the last step, to tell whether they were changed since
+	vec2 rest_position = { 0.f, 0.f };
+	vec2 rest_scale = { 0.f, 0.f };
+	vec2 rest_gravity = { 0.f, 0.f };
+};
+
 struct Block {
 	int x;
 	int y;
@@ -104,7 +186,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	Collision(Entity& other) : other(other) {}; // copy the handle, default constructing it would allocate a new entity
 	int direction = 0; // 1 for top, 2 for bottom, 3 for left, 4 for right
 };
 
@@ -124,7 +206,7 @@ struct ScreenState
 // A struct to refer to debugging graphics in the ECS
 struct DebugComponent
 {
-	// Note, an empty struct has size 1
+	// Note, an empty struct has size 1, but as a tag component it is not stored at all (see ComponentContainer)
 };
 
 // A timer that will be associated to dying salmon
@@ -154,6 +236,8 @@ struct Mesh
 	vec2 original_size = {1,1};
 	std::vector<ColoredVertex> vertices;
 	std::vector<uint16_t> vertex_indices;
+	// convex hull of the vertices in local space, see convex_hull
+	std::vector<vec2> hull;
 };
 
 struct Stage {
@@ -277,9 +361,9 @@ struct AnimationFrame {
   
 struct Laser {};
 
+// Only drawn, the player in its path is hit when it is fired (see WorldSystem::fire_laser2)
 struct Laser2 {
 	int side;
-	bool damagable = true;
 };
 
 struct Lifetime {
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+// Q16.16 fixed-point number: 16 integer bits (+-32767 px is plenty for the arena) and 16 fractional bits.
+// Its arithmetic is integer math, so unlike float it gives the same bits with every compiler, optimization level
+// (-ffast-math, fused multiply-add) and CPU. Used by PhysicsSystem when built with RB_FIXED_POINT_PHYSICS.
+// Results outside of the range saturate to its ends instead of overflowing, e.g. a time of impact divided by a
+// tiny displacement.
+struct fixed
+{
+	int32_t raw = 0;
+
+	fixed() = default;
+	// rounds to the nearest step, with the deterministic rounding of IEEE float
+	explicit fixed(float f) : raw(saturate(std::lround(std::max(std::min(f * 65536.f, 2147483520.f), -2147483648.f)))) {}
+	explicit operator float() const { return (float)raw / 65536.f; }
+
+	static fixed from_raw(int32_t r)
+	{
+		fixed f;
+		f.raw = r;
+		return f;
+	}
+
+	// the int64_t intermediates cannot overflow, only the narrowing back saturates
+	static int32_t saturate(int64_t r)
+	{
+		return (int32_t)std::max<int64_t>(std::min<int64_t>(r, INT32_MAX), INT32_MIN);
+	}
+
+	fixed operator+(fixed o) const { return from_raw(saturate((int64_t)raw + o.raw)); }
+	fixed operator-(fixed o) const { return from_raw(saturate((int64_t)raw - o.raw)); }
+	fixed operator-() const { return from_raw(saturate(-(int64_t)raw)); }
+	// rounds towards negative infinity
+	fixed operator*(fixed o) const { return from_raw(saturate(((int64_t)raw * o.raw) >> 16)); }
+	// rounds towards zero
+	fixed operator/(fixed o) const
+	{
+		assert(o.raw != 0 && "fixed division by zero");
+		return from_raw(saturate((int64_t)raw * 65536 / o.raw));
+	}
+	fixed& operator+=(fixed o) { return *this = *this + o; }
+	fixed& operator-=(fixed o) { return *this = *this - o; }
+	fixed& operator*=(fixed o) { return *this = *this * o; }
+
+	bool operator==(fixed o) const { return raw == o.raw; }
+	bool operator!=(fixed o) const { return raw != o.raw; }
+	bool operator<(fixed o) const { return raw < o.raw; }
+	bool operator>(fixed o) const { return raw > o.raw; }
+	bool operator<=(fixed o) const { return raw <= o.raw; }
+	bool operator>=(fixed o) const { return raw >= o.raw; }
+};
+
+inline fixed abs(fixed f) { return f.raw < 0 ? -f : f; }
+
+// The few vec2 operations the physics needs
+struct fixed2
+{
+	fixed x;
+	fixed y;
+
+	fixed2() = default;
+	fixed2(fixed x, fixed y) : x(x), y(y) {}
+	explicit fixed2(vec2 v) : x(v.x), y(v.y) {}
+	explicit operator vec2() const { return { (float)x, (float)y }; }
+
+	fixed2 operator+(fixed2 o) const { return { x + o.x, y + o.y }; }
+	fixed2 operator-(fixed2 o) const { return { x - o.x, y - o.y }; }
+	fixed2 operator*(fixed s) const { return { x * s, y * s }; }
+	fixed2& operator+=(fixed2 o) { x += o.x; y += o.y; return *this; }
+	fixed2& operator-=(fixed2 o) { x -= o.x; y -= o.y; return *this; }
+
+	bool operator==(fixed2 o) const { return x == o.x && y == o.y; }
+	bool operator!=(fixed2 o) const { return !(*this == o); }
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.hpp"
+#include "tiny_ecs.hpp"
+#include "components.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// Turns the time between rendered frames into a whole number of fixed simulation ticks, so that the cost and the
+// results of the simulation do not depend on the frame rate. The time left over is where the frame lies between
+// the last two ticks, see MotionHistory.
+class FixedTimestep
+{
+	float tick;
+	int max_ticks;
+	float accumulated_ms = 0.f;
+public:
+	FixedTimestep(float tick_ms, int max_ticks_per_frame) : tick(tick_ms), max_ticks(max_ticks_per_frame) {}
+
+	// Adds the time of one frame and returns how many ticks to run for it. After a hitch at most
+	// max_ticks_per_frame are run, the rest of the backlog is dropped.
+	int advance(float elapsed_ms)
+	{
+		accumulated_ms += elapsed_ms;
+		int ticks = 0;
+		while (accumulated_ms >= tick && ticks < max_ticks) {
+			accumulated_ms -= tick;
+			ticks++;
+		}
+		if (ticks == max_ticks)
+			accumulated_ms = std::min(accumulated_ms, tick);
+		return ticks;
+	}
+
+	// The fraction of a tick elapsed since the last one, 0..1
+	float alpha() const { return accumulated_ms / tick; }
+
+	float tick_ms() const { return tick; }
+};
+
+// Bodies that jump further in one tick than this were teleported (portals, restarts) and are not blended
+const float MAX_INTERPOLATED_DISTANCE = 100.f;
+
+// The motions of the previous simulation tick by entity index, so that a frame can draw the bodies in between
+// the last two ticks
+class MotionHistory
+{
+	struct PreviousMotion {
+		unsigned int owner = 0;
+		vec2 position;
+		float angle;
+	};
+	std::vector<PreviousMotion> previous_motions;
+public:
+	// Remembers where everything is before a simulation tick moves it
+	void store(const ComponentContainer<Motion>& motions)
+	{
+		for (uint i = 0; i < motions.entities.size(); i++)
+		{
+			Entity entity = motions.entities[i];
+			if (entity.index() >= previous_motions.size())
+				previous_motions.resize(entity.index() + 1);
+			const Motion& motion = motions.components[i];
+			previous_motions[entity.index()] = { entity, motion.position, motion.angle };
+		}
+	}
+
+	// The motion blended between the last two ticks, alpha as in FixedTimestep::alpha
+	Motion interpolated(Entity entity, const Motion& motion, float alpha) const
+	{
+		if (alpha >= 1.f || entity.index() >= previous_motions.size())
+			return motion;
+		const PreviousMotion& previous = previous_motions[entity.index()];
+		// created during the last tick
+		if (previous.owner != (unsigned int)entity || distance(previous.position, motion.position) > MAX_INTERPOLATED_DISTANCE)
+			return motion;
+
+		Motion blended = motion;
+		blended.position = mix(previous.position, motion.position, alpha);
+		blended.angle = mix(previous.angle, motion.angle, alpha);
+		return blended;
+	}
+};
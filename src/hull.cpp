@@ -0,0 +1,96 @@
+// internal
+#include "hull.hpp"
+
+// stlib
+#include <algorithm>
+
+// > 0 if o -> a -> b turns counter-clockwise
+static float cross(vec2 o, vec2 a, vec2 b)
+{
+	return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Andrew's monotone chain
+void convex_hull(const std::vector<ColoredVertex>& vertices, std::vector<vec2>& out_hull)
+{
+	std::vector<vec2> points;
+	points.reserve(vertices.size());
+	for (const ColoredVertex& vertex : vertices)
+		points.push_back({ vertex.position.x, vertex.position.y });
+	std::sort(points.begin(), points.end(), [](vec2 a, vec2 b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+	points.erase(std::unique(points.begin(), points.end()), points.end());
+
+	out_hull.clear();
+	if (points.size() < 3)
+	{
+		out_hull = points;
+		return;
+	}
+
+	out_hull.resize(2 * points.size());
+	size_t k = 0;
+	// lower chain, then upper chain, dropping points that do not turn left
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		while (k >= 2 && cross(out_hull[k - 2], out_hull[k - 1], points[i]) <= 0)
+			k--;
+		out_hull[k++] = points[i];
+	}
+	for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--)
+	{
+		while (k >= lower && cross(out_hull[k - 2], out_hull[k - 1], points[i - 1]) <= 0)
+			k--;
+		out_hull[k++] = points[i - 1];
+	}
+	// the last point is the first one again
+	out_hull.resize(k - 1);
+}
+
+void transform_hull(const std::vector<vec2>& hull, const Motion& motion, WorldHull& out_hull)
+{
+	float cos_theta = cos(motion.angle);
+	float sin_theta = sin(motion.angle);
+	// a mirrored mesh (negative scale on one axis, e.g. facing left) would turn clockwise, keep it counter-clockwise
+	bool mirrored = motion.scale.x * motion.scale.y < 0;
+
+	std::vector<vec2>& points = out_hull.points;
+	points.resize(hull.size());
+	for (size_t i = 0; i < hull.size(); i++)
+	{
+		vec2 v = hull[i] * motion.scale;
+		points[mirrored ? hull.size() - 1 - i : i] = vec2(v.x * cos_theta - v.y * sin_theta, v.x * sin_theta + v.y * cos_theta) + motion.position;
+	}
+
+	out_hull.min = out_hull.max = points.empty() ? motion.position : points[0];
+	for (vec2 p : points)
+	{
+		out_hull.min = min(out_hull.min, p);
+		out_hull.max = max(out_hull.max, p);
+	}
+}
+
+bool hull_overlaps_box(const WorldHull& hull, const BroadphaseBox& box)
+{
+	const std::vector<vec2>& points = hull.points;
+	if (points.empty())
+		return false;
+
+	// the axes of the box
+	if (hull.max.x < box.min.x || box.max.x < hull.min.x || hull.max.y < box.min.y || box.max.y < hull.min.y)
+		return false;
+	if (points.size() < 3)
+		return true;
+
+	// the outward edge normals of the hull. Being convex and counter-clockwise, the hull lies behind each edge, so
+	// only the box corner furthest inwards has to be projected.
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		vec2 p = points[i];
+		vec2 edge = points[(i + 1) % points.size()] - p;
+		vec2 normal = { edge.y, -edge.x };
+		vec2 corner = { normal.x < 0 ? box.max.x : box.min.x, normal.y < 0 ? box.max.y : box.min.y };
+		if (dot(corner - p, normal) > 0)
+			return false;
+	}
+	return true;
+}
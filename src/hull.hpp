@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.hpp"
+#include "components.hpp"
+#include "aabb_batch.hpp"
+
+#include <vector>
+
+// Convex hull of the mesh vertices (x and y only) in local space, counter-clockwise. Computed once per mesh
+// when it is loaded, see RenderSystem::initializeGlMeshes.
+void convex_hull(const std::vector<ColoredVertex>& vertices, std::vector<vec2>& out_hull);
+
+// A hull in world space, counter-clockwise, with its bounds
+struct WorldHull
+{
+	std::vector<vec2> points;
+	vec2 min = { 0.f, 0.f };
+	vec2 max = { 0.f, 0.f };
+};
+
+// Hull transformed as the mesh is drawn: scaled, rotated and translated by motion. Reuses the capacity of out_hull.
+void transform_hull(const std::vector<vec2>& hull, const Motion& motion, WorldHull& out_hull);
+
+// Separating axis test of the hull against a box, touching counts as overlapping. Does not allocate.
+bool hull_overlaps_box(const WorldHull& hull, const BroadphaseBox& box);
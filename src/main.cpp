@@ -5,14 +5,22 @@
 
 // stlib
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 // internal
+#include "fixed_timestep.hpp"
 #include "physics_system.hpp"
 #include "render_system.hpp"
 #include "world_system.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
+// The simulation runs in fixed ticks, see FixedTimestep
+const float TICK_MS = 1000.f / 120.f;
+// After a hitch at most this many ticks are run in one frame, the rest of the backlog is dropped
+const int MAX_TICKS_PER_FRAME = 8;
+
 // Entry point
 int main()
 {
@@ -21,6 +29,15 @@ int main()
 	RenderSystem renderer;
 	PhysicsSystem physics;
 
+	// RB_BROADPHASE=sap switches the collision broadphase to sweep and prune, to compare it with the grid
+	const char* broadphase = std::getenv("RB_BROADPHASE");
+	if (broadphase && strcmp(broadphase, "sap") == 0)
+		physics.set_broadphase(BROADPHASE_TYPE::SWEEP_AND_PRUNE);
+	// RB_PHYSICS_THREADS=n runs the collision narrowphase on n threads, e.g. to measure it on a multi-core machine
+	const char* physics_threads = std::getenv("RB_PHYSICS_THREADS");
+	if (physics_threads)
+		physics.set_thread_count((unsigned int)std::max(1, atoi(physics_threads)));
+
 	// Initializing window
 	GLFWwindow* window = world.create_window();
 	if (!window) {
@@ -32,11 +49,15 @@ int main()
 
 	// initialize the main systems
 	renderer.init(window);
-	world.init(&renderer);
+	world.init(&renderer, &physics);
 
-	// variable timestep loop
+	// fixed timestep loop, rendering as often as the display allows
 	auto t = Clock::now();
+	FixedTimestep timestep(TICK_MS, MAX_TICKS_PER_FRAME);
 	while (!world.is_over()) {
+		// Components written from here on get a new version, see ComponentContainer::changed_since
+		ChangeTick::advance();
+
 		// Processes system messages, if this wasn't present the window would become unresponsive
 		glfwPollEvents();
 
@@ -45,12 +66,21 @@ int main()
 		float elapsed_ms =
 			(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
 		t = now;
+		world.count_frame(elapsed_ms);
+
+		int ticks = timestep.advance(elapsed_ms);
+		for (int tick = 0; tick < ticks; tick++) {
+			renderer.store_previous_motions();
+
+			// Structural changes recorded by a system are applied before the next one runs
+			world.step(TICK_MS);
+			registry.flush_commands();
+			physics.step(TICK_MS);
+			world.handle_collisions();
+			registry.flush_commands();
+		}
 
-		world.step(elapsed_ms);
-		physics.step(elapsed_ms);
-		world.handle_collisions();
-
-		renderer.draw();
+		renderer.draw(timestep.alpha());
 
 		float text_height = 50.0f;
 
@@ -67,7 +97,7 @@ int main()
             for (size_t i = 0; i < registry.players.size(); i++)
             {
                 auto &player = registry.players.entities[i];
-                Motion &player_motion = registry.motions.get(player);
+                Motion player_motion = renderer.interpolated(player, registry.motions.peek(player));
 
                 // Prepare text
 				std::string text = "health + 3";
@@ -93,7 +123,7 @@ int main()
 if (registry.stageSelection != 0 && registry.stageSelection != 6 && world.rounds != 0) {
     for (Entity player_entity : registry.players.entities) {
         Player& player = registry.players.get(player_entity);
-        Motion& motion = registry.motions.get(player_entity);
+        Motion motion = renderer.interpolated(player_entity, registry.motions.peek(player_entity));
 
         // Health bar parameters
         const float max_health = 10.0f; // Adjust if maximum health differs
@@ -2,9 +2,20 @@
 #include "physics_system.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
-#include "world_init.hpp"
+#include "fixed_point.hpp"
 #include <iostream>
 
+// The scalar of the integration and of the collision tests of the narrowphase. RB_FIXED_POINT_PHYSICS makes it Q16.16,
+// so that a replay gives the same bits with any compiler and flags. Motion and Gravity stay float, the conversions
+// to and from them have deterministic rounding.
+#ifdef RB_FIXED_POINT_PHYSICS
+typedef fixed real;
+typedef fixed2 real2;
+#else
+typedef float real;
+typedef vec2 real2;
+#endif
+
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Motion& motion)
 {
@@ -13,183 +24,583 @@ vec2 get_bounding_box(const Motion& motion)
 }
 
 
+// Direction of a collision, x_axis if the bodies overlap less on x than on y
+int collision_direction(const Motion& motion1, const Motion& motion2, bool x_axis)
+{
+    if (x_axis) {
+        if (real(motion1.position[0]) < real(motion2.position[0])) return 3; // left collision
+        else return 4; // right collision
+    } else {
+        if (real(motion1.position[1]) < real(motion2.position[1])) return 1; // top collision
+        else return 2; // bot collision
+    }
+}
+
 int collides(const Motion& motion1, const Motion& motion2)
 {
-	float x1_left = motion1.position[0] - (abs(motion1.scale[0]) / 2);
-    float x1_right = motion1.position[0] + (abs(motion1.scale[0]) / 2);
-    float y1_top = motion1.position[1] - (abs(motion1.scale[1]) / 2);
-    float y1_bot = motion1.position[1] + (abs(motion1.scale[1]) / 2);
-    float x2_left = motion2.position[0] - (abs(motion2.scale[0]) / 2);
-    float x2_right = motion2.position[0] + (abs(motion2.scale[0]) / 2);
-    float y2_top = motion2.position[1] - (abs(motion2.scale[1]) / 2);
-    float y2_bot = motion2.position[1] + (abs(motion2.scale[1]) / 2);
+	real x1_left = real(motion1.position[0]) - real(abs(motion1.scale[0]) / 2);
+    real x1_right = real(motion1.position[0]) + real(abs(motion1.scale[0]) / 2);
+    real y1_top = real(motion1.position[1]) - real(abs(motion1.scale[1]) / 2);
+    real y1_bot = real(motion1.position[1]) + real(abs(motion1.scale[1]) / 2);
+    real x2_left = real(motion2.position[0]) - real(abs(motion2.scale[0]) / 2);
+    real x2_right = real(motion2.position[0]) + real(abs(motion2.scale[0]) / 2);
+    real y2_top = real(motion2.position[1]) - real(abs(motion2.scale[1]) / 2);
+    real y2_bot = real(motion2.position[1]) + real(abs(motion2.scale[1]) / 2);
 
     if (x1_left >= x2_right || x2_left >= x1_right) return 0; // no collision
     if (y1_top >= y2_bot || y2_top >= y1_bot) return 0; // no collision
-    float x_overlap = std::min(x1_right, x2_right) - std::max(x1_left, x2_left);
-    float y_overlap = std::min(y1_bot, y2_bot) - std::max(y1_top, y2_top);
+    real x_overlap = std::min(x1_right, x2_right) - std::max(x1_left, x2_left);
+    real y_overlap = std::min(y1_bot, y2_bot) - std::max(y1_top, y2_top);
 
-    if (x_overlap < y_overlap) {
-        if (motion1.position[0] < motion2.position[0]) return 3; // left collision
-        else return 4; // right collision
-    } else {
-        if (motion1.position[1] < motion2.position[1]) return 1; // top collision
-        else return 2; // bot collision
-    }
+    return collision_direction(motion1, motion2, x_overlap < y_overlap);
 }
 
-void compute_transformed_vertices(const Mesh& mesh, const Motion& motion, std::vector<vec2>& out_vertices)
+#ifdef RB_FIXED_POINT_PHYSICS
+// The float broadphase only finds the candidates and test_pair decides with the Q16.16 tests below. Its boxes are
+// grown by more than the float and the Q16.16 sides of a box can differ by in the arena, so that it finds every pair
+// the Q16.16 tests accept.
+const float BROADPHASE_SLACK = 1.f / 256.f;
+
+// The box of collides()
+struct RealBox
 {
-    out_vertices.clear();
-    out_vertices.reserve(mesh.vertices.size());
+	real2 min;
+	real2 max;
+};
 
-    float cos_theta = cos(motion.angle);
-    float sin_theta = sin(motion.angle);
+static RealBox real_box(const Motion& motion)
+{
+	real2 half = real2(abs(motion.scale) / 2.f);
+	return { real2(motion.position) - half, real2(motion.position) + half };
+}
 
-    for (const ColoredVertex& vertex : mesh.vertices)
-    {
-        vec2 v = { vertex.position.x * motion.scale.x, vertex.position.y * motion.scale.y };
-        vec2 v_rotated = { v.x * cos_theta - v.y * sin_theta, v.x * sin_theta + v.y * cos_theta };
-        vec2 v_transformed = v_rotated + motion.position;
-        out_vertices.push_back(v_transformed);
-    }
+// aabb_overlap in Q16.16
+static bool real_overlap(const RealBox& a, const RealBox& b, bool& x_axis)
+{
+	if (!(a.min.x < b.max.x && b.min.x < a.max.x && a.min.y < b.max.y && b.min.y < a.max.y))
+		return false;
+	real x_overlap = std::min(a.max.x, b.max.x) - std::max(a.min.x, b.min.x);
+	real y_overlap = std::min(a.max.y, b.max.y) - std::max(a.min.y, b.min.y);
+	x_axis = x_overlap < y_overlap;
+	return true;
 }
 
-bool mesh_collides(Entity entity_i, Entity entity_j)
+// aabb_sweep in Q16.16
+static bool real_sweep(const RealBox& a, real2 displacement, const RealBox& b, real& t, bool& x_axis)
 {
-    Motion& motion_j = registry.motions.get(entity_j);
-    Motion& motion_i = registry.motions.get(entity_i);
-    Mesh* mesh1 = registry.meshPtrs.get(entity_j);
+	if (real_overlap(a, b, x_axis)) {
+		t = real(0.f);
+		return true;
+	}
 
-    std::vector<vec2> transformed_vertices;
-    compute_transformed_vertices(*mesh1, motion_j, transformed_vertices);
+	real t_enter = real(0.f), t_exit = real(1.f);
+	for (int axis = 0; axis < 2; axis++)
+	{
+		real d = axis == 0 ? displacement.x : displacement.y;
+		real a_min = axis == 0 ? a.min.x : a.min.y, a_max = axis == 0 ? a.max.x : a.max.y;
+		real b_min = axis == 0 ? b.min.x : b.min.y, b_max = axis == 0 ? b.max.x : b.max.y;
+		if (d == real(0.f))
+		{
+			// never overlaps on this axis
+			if (a_min >= b_max || b_min >= a_max)
+				return false;
+			continue;
+		}
+		real t0 = (b_min - a_max) / d;
+		real t1 = (b_max - a_min) / d;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > t_enter) {
+			t_enter = t0;
+			x_axis = axis == 0;
+		}
+		t_exit = std::min(t_exit, t1);
+		if (t_enter >= t_exit)
+			return false;
+	}
+	t = t_enter;
+	return true;
+}
+#endif
 
-    // Get the bounding box for entity_i (portal)
-    vec2 portal_min = motion_i.position - abs(motion_i.scale / 2.f);
-    vec2 portal_max = motion_i.position + abs(motion_i.scale / 2.f);
+// Bodies without a PhysicsBody are kinematic and on the DEFAULT layer
+static PhysicsBody body_of(Entity entity)
+{
+	PhysicsBody* body = registry.physicsBodies.try_peek(entity);
+	return body ? *body : PhysicsBody();
+}
 
-    for (size_t i = 0; i < mesh1->vertex_indices.size(); i += 1)
-    {
-        vec2& v1 = transformed_vertices[mesh1->vertex_indices[i]];
+void PhysicsSystem::set_thread_count(unsigned int threads)
+{
+	pool.reset(new ThreadPool(std::max(threads, 1u) - 1));
+}
 
-        // Check if the transformed vertex is within the portal's bounding box
-        if (v1.x >= portal_min.x && v1.x <= portal_max.x &&
-            v1.y >= portal_min.y && v1.y <= portal_max.y)
-        {
-            return true; // Collision detected
-        }
-    }
+void PhysicsSystem::set_sleep_ticks(unsigned int ticks)
+{
+	sleep_ticks = ticks;
+	if (ticks == 0)
+		for (PhysicsBody& body : registry.physicsBodies.components)
+			body.asleep = false;
+}
+
+// Runs at the start of a step, after the world reacted to the collisions of the last one
+void PhysicsSystem::update_sleep()
+{
+	ComponentContainer<PhysicsBody>& bodies = registry.physicsBodies;
+	for (uint i = 0; i < bodies.size(); i++)
+	{
+		PhysicsBody& body = bodies.components[i];
+		Entity entity = bodies.entities[i];
+		const Motion* motion = registry.motions.try_peek(entity);
+		if (body.type == BODY_TYPE::STATIC || !motion)
+			continue;
+		const Gravity* gravity = registry.gravities.try_peek(entity);
+		vec2 g = gravity ? gravity->g : vec2(0.f, 0.f);
 
-    return false; // No collision
+		// the values are compared rather than the versions, as WorldSystem gets the players' motions every frame
+		bool still = motion->velocity == vec2(0.f, 0.f) && motion->position == body.rest_position &&
+			motion->scale == body.rest_scale && g == body.rest_gravity;
+		if (!still) {
+			body.asleep = false;
+			body.still_ticks = 0;
+		} else if (!body.asleep && sleep_ticks > 0 && ++body.still_ticks >= sleep_ticks) {
+			body.asleep = true;
+		}
+		body.rest_position = motion->position;
+		body.rest_scale = motion->scale;
+		body.rest_gravity = g;
+	}
 }
 
+void PhysicsSystem::set_broadphase(BROADPHASE_TYPE type)
+{
+	broadphase = make_broadphase(type);
+}
+
+void PhysicsSystem::set_layers_collide(COLLISION_LAYER a, COLLISION_LAYER b, bool collide)
+{
+	unsigned int bit_a = layer_bit(a), bit_b = layer_bit(b);
+	if (collide) {
+		layer_masks[(int)a] |= bit_b;
+		layer_masks[(int)b] |= bit_a;
+	} else {
+		layer_masks[(int)a] &= ~bit_b;
+		layer_masks[(int)b] &= ~bit_a;
+	}
+}
+
+void PhysicsSystem::set_default_layers()
+{
+	for (unsigned int& mask : layer_masks)
+		mask = 0;
+	for (int layer = 0; layer < collision_layer_count; layer++)
+		if (layer != (int)COLLISION_LAYER::NONE)
+			set_layers_collide(COLLISION_LAYER::DEFAULT, (COLLISION_LAYER)layer, true);
+
+	const COLLISION_LAYER player_hits[] = { COLLISION_LAYER::BLOCK, COLLISION_LAYER::BULLET, COLLISION_LAYER::GRENADE,
+		COLLISION_LAYER::PORTAL, COLLISION_LAYER::ITEM };
+	for (COLLISION_LAYER layer : player_hits)
+		set_layers_collide(COLLISION_LAYER::PLAYER, layer, true);
+	set_layers_collide(COLLISION_LAYER::BLOCK, COLLISION_LAYER::BULLET, true);
+	set_layers_collide(COLLISION_LAYER::BLOCK, COLLISION_LAYER::GRENADE, true);
+	set_layers_collide(COLLISION_LAYER::BULLET, COLLISION_LAYER::BULLET, true);
+	set_layers_collide(COLLISION_LAYER::PORTAL, COLLISION_LAYER::BULLET, true);
+	set_layers_collide(COLLISION_LAYER::PORTAL, COLLISION_LAYER::GRENADE, true);
+}
+
+// Runs before the narrowphase, which then only reads the cache
+void PhysicsSystem::update_hulls()
+{
+	for (Entity entity : registry.portals.entities)
+	{
+		Mesh** mesh = registry.meshPtrs.try_peek(entity);
+		if (!mesh || !registry.motions.has(entity))
+			continue;
+		assert(!(*mesh)->hull.empty() && "Mesh hull not computed, see convex_hull");
+
+		unsigned int version = registry.motions.version(entity);
+		if (entity.index() >= hull_cache.size())
+			hull_cache.resize(entity.index() + 1);
+		CachedHull& cached = hull_cache[entity.index()];
+		if (cached.owner == (unsigned int)entity && cached.version == version && !cached.hull.points.empty())
+			continue;
+
+		transform_hull((*mesh)->hull, registry.motions.peek(entity), cached.hull);
+		cached.owner = entity;
+		cached.version = version;
+	}
+}
+
+const WorldHull& PhysicsSystem::hull_of(Entity entity) const
+{
+	assert(entity.index() < hull_cache.size() && hull_cache[entity.index()].owner == (unsigned int)entity);
+	return hull_cache[entity.index()].hull;
+}
+
+// Tests a pair with a FastMover with the boxes swept this step. Returns whether they collide and when they first
+// touched, so that the fast mover can be moved back to it.
+bool PhysicsSystem::sweep_pair(uint i, uint j, bool& x_axis, float& impact_time) const
+{
+	const Motion& motion_i = registry.motions.components[i];
+	const Motion& motion_j = registry.motions.components[j];
+	impact_time = 1.f;
+#ifdef RB_FIXED_POINT_PHYSICS
+	RealBox end_i = real_box(motion_i);
+	RealBox end_j = real_box(motion_j);
+	if (real_overlap(end_i, end_j, x_axis))
+		return true;
+
+	// the displacements were rounded to float from Q16.16, which is exact for moves under 256 px a step
+	real2 displacement_i = real2(displacements[i]);
+	real2 displacement_j = real2(displacements[j]);
+	RealBox start_i = { end_i.min - displacement_i, end_i.max - displacement_i };
+	RealBox start_j = { end_j.min - displacement_j, end_j.max - displacement_j };
+	real t;
+	if (!real_sweep(start_i, displacement_i - displacement_j, start_j, t, x_axis))
+		return false;
+	impact_time = (float)t;
+	return true;
+#else
+	BroadphaseBox end_i = bounding_box(motion_i);
+	BroadphaseBox end_j = bounding_box(motion_j);
+	if (aabb_overlap(end_i, end_j, x_axis))
+		return true;
+
+	// relative to j, as if j stayed where it was at the start of the step
+	BroadphaseBox start_i = { end_i.min - displacements[i], end_i.max - displacements[i] };
+	BroadphaseBox start_j = { end_j.min - displacements[j], end_j.max - displacements[j] };
+	return aabb_sweep(start_i, displacements[i] - displacements[j], start_j, impact_time, x_axis);
+#endif
+}
+
+bool PhysicsSystem::test_pair(const BroadphasePair& pair, Contact& contact) const
+{
+	uint i = pair.first;
+	uint j = pair.second;
+	ComponentContainer<Motion>& motion_container = registry.motions;
+	const Motion& motion_i = motion_container.components[i];
+	const Motion& motion_j = motion_container.components[j];
+	Entity entity_i = motion_container.entities[i];
+	Entity entity_j = motion_container.entities[j];
+
+	// the broadphase already did the overlap test of collides(), except for the swept boxes
+	bool x_axis = pair.x_axis;
+	float impact_time = 1.f;
+	if (displacements[i] != vec2(0.f, 0.f) || displacements[j] != vec2(0.f, 0.f)) {
+		if (!sweep_pair(i, j, x_axis, impact_time))
+			return false;
+	}
+#ifdef RB_FIXED_POINT_PHYSICS
+	// the broadphase only tested the grown float boxes
+	else if (!real_overlap(real_box(motion_i), real_box(motion_j), x_axis))
+		return false;
+#endif
+
+	// mesh collision code: the portal hull against the box of whatever touches it, swept for fast movers
+	bool portal_i = registry.has<Portal>(entity_i) && registry.meshPtrs.has(entity_i);
+	bool portal_j = registry.has<Portal>(entity_j) && registry.meshPtrs.has(entity_j);
+	if (portal_i != portal_j) {
+		if (portal_i ? !hull_overlaps_box(hull_of(entity_i), boxes[j]) : !hull_overlaps_box(hull_of(entity_j), boxes[i]))
+			return false;
+	}
+
+	contact = { i, j, collision_direction(motion_i, motion_j, x_axis), impact_time };
+	return true;
+}
 
 void PhysicsSystem::step(float elapsed_ms)
 {
 	float step_seconds = elapsed_ms / 1000.f;
+	real dt = real(step_seconds);
+	update_sleep();
 	auto& motion_registry = registry.motions;
+	displacements.assign(motion_registry.size(), vec2(0.f, 0.f));
+	impact_times.assign(motion_registry.size(), 1.f);
 	for(uint i = 0; i< motion_registry.size(); i++)
 	{
 		Motion& motion = motion_registry.components[i];
-		Entity entity = motion_registry.entities[i];
-		if (registry.blocks.has(entity)) {
-			Block& block = registry.blocks.get(entity);
-			block.travelled_dist = motion.velocity * step_seconds;
+		// resting entities (static blocks, backgrounds, ...) keep their version, so cached transforms stay valid
+		PhysicsBody body = body_of(motion_registry.entities[i]);
+		if (motion.velocity != vec2(0.f, 0.f) && body.type != BODY_TYPE::STATIC && !body.asleep) {
+			real2 displacement = real2(motion.velocity) * dt;
+			motion.position = vec2(real2(motion.position) + displacement);
+			motion_registry.mark_changed(i);
+			if (registry.fastMovers.has(motion_registry.entities[i]))
+				displacements[i] = vec2(displacement);
 		}
-		motion.position += motion.velocity * step_seconds;
 	}
 
-	auto& gravity_registry = registry.gravities;
-	for(uint i = 0; i< gravity_registry.size(); i++) 
-	{
-		Gravity& gravity = gravity_registry.components[i];
-		Entity entity = gravity_registry.entities[i];
-		Motion& motion = registry.motions.get(entity);
-		motion.velocity += gravity.g * step_seconds;
+	registry.view<Block, Motion>().read_only<Motion>().each([&](Entity, Block& block, Motion& motion) {
+		block.travelled_dist = vec2(real2(motion.velocity) * dt);
+	});
+
+	// only the bodies whose velocity changed are marked, so that sleeping and resting bodies keep their version
+	registry.view<Gravity, Motion>().read_only<Gravity>().each([&](Entity entity, Gravity& gravity, Motion& motion) {
+		// a sleeping body would only gain speed to lose it again in handle_collisions
+		if (body_of(entity).asleep)
+			return false;
+		real2 velocity = real2(motion.velocity) + real2(gravity.g) * dt;
 
-		float signx = (motion.velocity[0] > 0) - (motion.velocity[0] < 0);
+		float signx = (velocity.x > real(0.f)) - (velocity.x < real(0.f));
 		if (gravity.drag) {
-			motion.velocity[0] += -1 * signx * step_seconds * 800.f;
-			if ((motion.velocity[0] > 0) - (motion.velocity[0] < 0) != signx) {
-				motion.velocity[0] = 0.f;
+			velocity.x += real(-1 * signx) * dt * real(800.f);
+			if ((velocity.x > real(0.f)) - (velocity.x < real(0.f)) != signx) {
+				velocity.x = real(0.f);
 			}
 		}
 
-		float signy = (motion.velocity[1] > 0) - (motion.velocity[1] < 0);
-		if (registry.players.has(entity)) {
-			if (abs(motion.velocity[0]) > 350) motion.velocity[0] = signx * 350;
-			if (abs(motion.velocity[1]) > 700) motion.velocity[1] = signy * 700;
-		} 
-	}	
+		float signy = (velocity.y > real(0.f)) - (velocity.y < real(0.f));
+		if (registry.has<Player>(entity)) {
+			if (abs(velocity.x) > real(350.f)) velocity.x = real(signx * 350);
+			if (abs(velocity.y) > real(700.f)) velocity.y = real(signy * 700);
+		}
+		if (vec2(velocity) == motion.velocity)
+			return false;
+		motion.velocity = vec2(velocity);
+		return true;
+	});
 
-	auto& block_registry = registry.blocks;
-	for(uint i = 0; i< block_registry.size(); i++)
-	{
-		Block& block = block_registry.components[i];
-		Entity entity = block_registry.entities[i];
-		Motion& motion = registry.motions.get(entity);
+	// only the blocks that turn around are marked
+	registry.view<Block, Motion>().read_only<Block>().each([&](Entity, Block& block, Motion& motion) {
+		vec2 velocity = motion.velocity;
 		if (block.moving == 1 || block.moving == 3) {
 			if (motion.position.x > window_width_px - 200) {
-				motion.velocity.x = -abs(motion.velocity.x);
+				velocity.x = -abs(velocity.x);
 			} else if (motion.position.x < 200) {
-				motion.velocity.x = abs(motion.velocity.x);
+				velocity.x = abs(velocity.x);
 			}
 		}
 		else if (block.moving == 2) {
 			if (motion.position.y > window_height_px - 200) {
-				motion.velocity.y = -abs(motion.velocity.y);
+				velocity.y = -abs(velocity.y);
 			} else if (motion.position.y < 200) {
-				motion.velocity.y = abs(motion.velocity.y);
+				velocity.y = abs(velocity.y);
 			}
 		}
+		if (velocity == motion.velocity)
+			return false;
+		motion.velocity = velocity;
+		return true;
+	});
+
+	// Check for collisions between all moving entities. The broadphase only reports pairs whose boxes overlap,
+	// that have a dynamic body and whose layers collide, along with the overlap axis that gives the direction.
+	ComponentContainer<Motion> &motion_container = registry.motions;
+	boxes.resize(motion_container.components.size());
+	box_entities.assign(motion_container.entities.begin(), motion_container.entities.end());
+	box_tick = ChangeTick::current();
+	stale_boxes_valid = false;
+	for (uint i = 0; i < motion_container.components.size(); i++)
+	{
+		PhysicsBody body = body_of(motion_container.entities[i]);
+		boxes[i] = bounding_box(motion_container.components[i]);
+		// a fast mover is found by everything along its path, sweep_pair then decides whether it really hit
+		vec2 displacement = displacements[i];
+		boxes[i].min = min(boxes[i].min, boxes[i].min - displacement);
+		boxes[i].max = max(boxes[i].max, boxes[i].max - displacement);
+#ifdef RB_FIXED_POINT_PHYSICS
+		boxes[i].min -= vec2(BROADPHASE_SLACK);
+		boxes[i].max += vec2(BROADPHASE_SLACK);
+#endif
+		boxes[i].dynamic = body.type == BODY_TYPE::DYNAMIC;
+		boxes[i].resting = body.type == BODY_TYPE::STATIC || body.asleep;
+		boxes[i].layer_bit = layer_bit(body.layer);
+		boxes[i].mask = layer_masks[(int)body.layer];
 	}
+	broadphase->find_pairs(boxes, pairs);
+	update_hulls();
+
+	// The narrowphase runs on contiguous ranges of the sorted pairs, each into its own buffer. Appending the
+	// buffers in range order gives the contacts in pair order, as a single thread would.
+	const size_t PAIRS_PER_RANGE = 256;
+	unsigned int ranges = (unsigned int)std::min<size_t>((pairs.size() + PAIRS_PER_RANGE - 1) / PAIRS_PER_RANGE, pool->concurrency() * 4);
+	if (contact_buffers.size() < ranges)
+		contact_buffers.resize(ranges);
+	pool->run(ranges, [&](unsigned int range) {
+		size_t begin = pairs.size() * range / ranges;
+		size_t end = pairs.size() * (range + 1) / ranges;
+		std::vector<Contact>& contacts = contact_buffers[range];
+		contacts.clear();
+		Contact contact;
+		for (size_t p = begin; p < end; p++)
+			if (test_pair(pairs[p], contact))
+				contacts.push_back(contact);
+	});
 
-	// Check for collisions between all moving entities
-    ComponentContainer<Motion> &motion_container = registry.motions;
-	for(uint i = 0; i<motion_container.components.size(); i++)
+	for (unsigned int range = 0; range < ranges; range++)
 	{
-		Motion& motion_i = motion_container.components[i];
-		Entity entity_i = motion_container.entities[i];
-		
-		// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-		for(uint j = i+1; j<motion_container.components.size(); j++)
+		for (const Contact& contact : contact_buffers[range])
 		{
-			
-			Motion& motion_j = motion_container.components[j];
-			int collision = collides(motion_i, motion_j);
-			
-			if (collision)
+			Entity entity_i = motion_container.entities[contact.i];
+			Entity entity_j = motion_container.entities[contact.j];
+			// Create a collisions event
+			// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+			auto& collision1 = registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+			collision1.direction = contact.direction;
+			auto& collision2 = registry.collisions.emplace_with_duplicates(entity_j, entity_i);
+			collision2.direction = contact.direction;
+
+			impact_times[contact.i] = std::min(impact_times[contact.i], contact.impact_time);
+			impact_times[contact.j] = std::min(impact_times[contact.j], contact.impact_time);
+
+			// only awake bodies reach sleeping ones, and wake them
+			for (Entity entity : { entity_i, entity_j })
 			{
-				Entity entity_j = motion_container.entities[j];
-			
-				if (registry.players.has(entity_i) && registry.portals.has(entity_j)) {
-					// mesh collision code
-					if (mesh_collides(entity_i, entity_j)) {
-						auto& collision1 = registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-						collision1.direction = collision;
-						auto& collision2 = registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-						collision2.direction = collision;
-					}
-				} else if (registry.players.has(entity_j) && registry.portals.has(entity_i)) {
-					// mesh collision code
-					if (mesh_collides(entity_j, entity_i)) {
-						auto& collision1 = registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-						collision1.direction = collision;
-						auto& collision2 = registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-						collision2.direction = collision;
-					}
-				} else {
-					// Create a collisions event
-					// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-					auto& collision1 = registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-					collision1.direction = collision;
-					auto& collision2 = registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-					collision2.direction = collision;
+				PhysicsBody* body = registry.physicsBodies.try_peek(entity);
+				if (body && body->asleep) {
+					body->asleep = false;
+					body->still_ticks = 0;
 				}
-		
 			}
 		}
 	}
+
+	// Fast movers that hit something end the step where they first touched it, instead of behind it
+	for (uint i = 0; i < motion_container.components.size(); i++)
+	{
+		if (impact_times[i] < 1.f && displacements[i] != vec2(0.f, 0.f)) {
+			Motion& motion = motion_container.components[i];
+			motion.position = vec2(real2(motion.position) - real2(displacements[i]) * (real(1.f) - real(impact_times[i])));
+			motion_container.mark_changed(i);
+		}
+	}
+}
+
+// The broadphase overlap is strict, the callers decide about touching bodies against their current Motion
+const float QUERY_MARGIN = 1.f;
+
+// Whether motion i is not the body the box i of the last step was taken of, or has left that box since. The step
+// itself writes the motions at box_tick, so those only count when they are outside of their box.
+bool PhysicsSystem::box_is_stale(uint i) const
+{
+	const ComponentContainer<Motion>& motions = registry.motions;
+	if (i >= motions.components.size() || i >= box_entities.size() || motions.entities[i] != box_entities[i])
+		return true;
+	if (motions.versions[i] != box_tick)
+		return motions.versions[i] > box_tick;
+	BroadphaseBox now = bounding_box(motions.components[i]);
+	return now.min.x < boxes[i].min.x || now.min.y < boxes[i].min.y || now.max.x > boxes[i].max.x || now.max.y > boxes[i].max.y;
+}
+
+// A scan over all motions, but only once for all the queries until the motions are modified again
+void PhysicsSystem::update_stale_boxes()
+{
+	const ComponentContainer<Motion>& motions = registry.motions;
+	if (stale_boxes_valid && stale_boxes_modifications == motions.modifications())
+		return;
+	stale_boxes_valid = true;
+	stale_boxes_modifications = motions.modifications();
+
+	stale_boxes.assign(std::max(boxes.size(), motions.components.size()), false);
+	stale_motions.clear();
+	for (uint i = 0; i < stale_boxes.size(); i++)
+	{
+		stale_boxes[i] = box_is_stale(i);
+		if (stale_boxes[i] && i < motions.components.size())
+			stale_motions.push_back(i);
+	}
 }
 
+void PhysicsSystem::find_candidates(vec2 min, vec2 max, unsigned int mask)
+{
+	BroadphaseBox box;
+	box.min = min - vec2(QUERY_MARGIN);
+	box.max = max + vec2(QUERY_MARGIN);
+	box.mask = mask;
+	broadphase->query(boxes, box, query_boxes);
 
+	// the boxes of bodies that were removed or changed since are skipped, those bodies are added where they are now
+	update_stale_boxes();
+	candidates.clear();
+	for (unsigned int i : query_boxes)
+		if (!stale_boxes[i])
+			candidates.push_back(box_entities[i]);
+	for (unsigned int i : stale_motions)
+	{
+		Entity entity = registry.motions.entities[i];
+		if (mask & layer_bit(body_of(entity).layer))
+			candidates.push_back(entity);
+	}
+}
+
+bool PhysicsSystem::raycast(vec2 start, vec2 end, unsigned int mask, QueryHit& hit)
+{
+	segment_sweep(start, end, { 0.f, 0.f }, mask, ray_hits);
+	if (ray_hits.empty())
+		return false;
+	hit = ray_hits.front();
+	return true;
+}
+
+void PhysicsSystem::segment_sweep(vec2 start, vec2 end, vec2 half_size, unsigned int mask, std::vector<QueryHit>& hits)
+{
+	hits.clear();
+	find_candidates(min(start, end) - half_size, max(start, end) + half_size, mask);
+
+#ifdef RB_FIXED_POINT_PHYSICS
+	RealBox moved = { real2(start) - real2(half_size), real2(start) + real2(half_size) };
+	real2 real_displacement = real2(end) - real2(start);
+#else
+	BroadphaseBox moved = { start - half_size, start + half_size };
+#endif
+	vec2 displacement = end - start;
+	for (Entity entity : candidates)
+	{
+		float t;
+		bool x_axis;
+#ifdef RB_FIXED_POINT_PHYSICS
+		real real_t;
+		if (!real_sweep(moved, real_displacement, real_box(registry.motions.peek(entity)), real_t, x_axis))
+			continue;
+		t = (float)real_t;
+#else
+		if (!aabb_sweep(moved, displacement, bounding_box(registry.motions.peek(entity)), t, x_axis))
+			continue;
+#endif
+		vec2 normal = { 0.f, 0.f };
+		if (t > 0.f && x_axis)
+			normal.x = displacement.x > 0.f ? -1.f : 1.f;
+		else if (t > 0.f)
+			normal.y = displacement.y > 0.f ? -1.f : 1.f;
+		hits.push_back({ entity, t, start + displacement * t, normal });
+	}
+	// the candidates are in the order of the last step, which breaks ties the same way every time
+	std::stable_sort(hits.begin(), hits.end(), [](const QueryHit& a, const QueryHit& b) { return a.fraction < b.fraction; });
+}
+
+void PhysicsSystem::overlap_aabb(vec2 min, vec2 max, unsigned int mask, std::vector<Entity>& found)
+{
+	found.clear();
+	find_candidates(min, max, mask);
+
+#ifdef RB_FIXED_POINT_PHYSICS
+	RealBox box = { real2(min), real2(max) };
+#else
+	BroadphaseBox box = { min, max };
+#endif
+	for (Entity entity : candidates)
+	{
+		bool x_axis;
+#ifdef RB_FIXED_POINT_PHYSICS
+		if (real_overlap(box, real_box(registry.motions.peek(entity)), x_axis))
+#else
+		if (aabb_overlap(box, bounding_box(registry.motions.peek(entity)), x_axis))
+#endif
+			found.push_back(entity);
+	}
+}
+
+void PhysicsSystem::overlap_circle(vec2 center, float radius, unsigned int mask, std::vector<Entity>& found)
+{
+	found.clear();
+	find_candidates(center - vec2(radius), center + vec2(radius), mask);
+
+	for (Entity entity : candidates)
+	{
+		BroadphaseBox box = bounding_box(registry.motions.peek(entity));
+		vec2 closest = clamp(center, box.min, box.max);
+		vec2 d = closest - center;
+		if (dot(d, d) <= radius * radius)
+			found.push_back(entity);
+	}
+}
@@ -4,8 +4,21 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "broadphase.hpp"
+#include "thread_pool.hpp"
+#include "hull.hpp"
 
 int collides(const Motion& motion1, const Motion& motion2);
+int collision_direction(const Motion& motion1, const Motion& motion2, bool x_axis);
+
+// A body found by PhysicsSystem::raycast or segment_sweep
+struct QueryHit
+{
+	Entity entity;
+	float fraction; // of the way from start to end when it was first touched, 0 if it was touched from the start
+	vec2 point; // where the center of the moved box was then
+	vec2 normal; // the side of the body that was touched, zero if it was touched from the start
+};
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
@@ -15,5 +28,90 @@ public:
 
 	PhysicsSystem()
 	{
+		set_broadphase(BROADPHASE_TYPE::GRID);
+		set_default_layers();
+		// serial until the parallel narrowphase is measured to be faster on multi-core machines
+		set_thread_count(1);
 	}
+
+	// Picks the algorithm that finds the candidate pairs, the collisions found are the same with either
+	void set_broadphase(BROADPHASE_TYPE type);
+
+	// The interaction matrix: whether bodies on layers a and b are tested against each other (symmetric)
+	void set_layers_collide(COLLISION_LAYER a, COLLISION_LAYER b, bool collide);
+	// Only the pairs WorldSystem::handle_collisions reacts to
+	void set_default_layers();
+
+	// Threads for the narrowphase, including the one calling step(); 1 (the default) runs it serially. The collisions
+	// and their order are the same with any number of threads.
+	void set_thread_count(unsigned int threads);
+
+	// Ticks a body has to keep still before it falls asleep, see PhysicsBody; 0 disables sleeping
+	void set_sleep_ticks(unsigned int ticks);
+
+	// Spatial queries, answered by the broadphase of the last step. Only bodies on a layer in mask (see layer_bit)
+	// are found, tested against their current Motion. Bodies created, moved or removed since the last step (spawns,
+	// portals, landing snaps) are found too: they are tested one by one, see update_stale_boxes.
+
+	// The first body on the segment from start to end
+	bool raycast(vec2 start, vec2 end, unsigned int mask, QueryHit& hit);
+	// The bodies a box of half_size touches while moving from start to end, in the order it touches them
+	void segment_sweep(vec2 start, vec2 end, vec2 half_size, unsigned int mask, std::vector<QueryHit>& hits);
+	// The bodies that overlap the box from min to max, as collides() would
+	void overlap_aabb(vec2 min, vec2 max, unsigned int mask, std::vector<Entity>& found);
+	// The bodies within radius of center, touching included
+	void overlap_circle(vec2 center, float radius, unsigned int mask, std::vector<Entity>& found);
+
+private:
+	std::unique_ptr<Broadphase> broadphase;
+	// bit b of layer_masks[a] is set if layers a and b collide
+	unsigned int layer_masks[collision_layer_count];
+	unsigned int sleep_ticks = 60; // half a second at 120 Hz
+	void update_sleep();
+	// per-frame broadphase buffers, kept to avoid allocating every step
+	std::vector<BroadphaseBox> boxes;
+	std::vector<BroadphasePair> pairs;
+	// the entity of each box, for the queries between steps
+	std::vector<Entity> box_entities;
+	// the ChangeTick at which the boxes were taken
+	unsigned int box_tick = 0;
+	bool box_is_stale(uint i) const;
+	// box_is_stale by index and the motions it is true for, found again when the motions were modified since
+	std::vector<char> stale_boxes;
+	std::vector<unsigned int> stale_motions;
+	bool stale_boxes_valid = false;
+	unsigned int stale_boxes_modifications = 0;
+	void update_stale_boxes();
+	std::vector<unsigned int> query_boxes;
+	std::vector<Entity> candidates;
+	std::vector<QueryHit> ray_hits;
+	void find_candidates(vec2 min, vec2 max, unsigned int mask);
+	// by motion index: how far a FastMover moved this step (zero for the others) and when it first hit something
+	std::vector<vec2> displacements;
+	std::vector<float> impact_times;
+
+	// World-space hull of each portal mesh by entity index, recomputed only when its Motion changed
+	struct CachedHull {
+		unsigned int owner = 0;
+		unsigned int version = 0;
+		WorldHull hull;
+	};
+	std::vector<CachedHull> hull_cache;
+	void update_hulls();
+	const WorldHull& hull_of(Entity entity) const;
+
+	// A pair that passed the narrowphase, by motion index
+	struct Contact {
+		uint i;
+		uint j;
+		int direction;
+		float impact_time; // 1 unless a fast mover hit before the end of the step
+	};
+	std::unique_ptr<ThreadPool> pool;
+	// one per range of pairs, so that appending them in order does not depend on which thread ran which range
+	std::vector<std::vector<Contact>> contact_buffers;
+
+	// Only reads the registry, so it can run on any thread
+	bool test_pair(const BroadphasePair& pair, Contact& contact) const;
+	bool sweep_pair(uint i, uint j, bool& x_axis, float& impact_time) const;
 };
\ No newline at end of file
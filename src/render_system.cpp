@@ -20,22 +20,57 @@
 #include <thread>
 
 
-void RenderSystem::drawTexturedMesh(Entity entity,
-									const mat3 &projection)
+void RenderSystem::store_previous_motions()
+{
+	motion_history.store(registry.motions);
+}
+
+Motion RenderSystem::interpolated(Entity entity, const Motion& motion) const
 {
-	Motion &motion = registry.motions.get(entity);
+	return motion_history.interpolated(entity, motion, alpha);
+}
+
+const mat3& RenderSystem::cachedTransform(Entity entity, const Motion& motion)
+{
+	// bodies that moved in the last tick are drawn in between two ticks, which changes every frame
+	Motion blended = interpolated(entity, motion);
+	if (blended.position != motion.position || blended.angle != motion.angle)
+	{
+		Transform transform;
+		transform.translate(blended.position);
+		transform.rotate(blended.angle);
+		transform.scale(blended.scale);
+		blended_transform = transform.mat;
+		return blended_transform;
+	}
+
+	unsigned int version = registry.motions.version(entity);
+	if (entity.index() >= transform_cache.size())
+		transform_cache.resize(entity.index() + 1);
+	CachedTransform& cached = transform_cache[entity.index()];
+	if (cached.owner == (unsigned int)entity && cached.version == version)
+		return cached.mat;
+
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
 	Transform transform;
 	transform.translate(motion.position);
-    transform.rotate(motion.angle);
-    transform.scale(motion.scale);
-	// !!! TODO A1: add rotation to the chain of transformations, mind the order
-	// of transformations
+	transform.rotate(motion.angle);
+	transform.scale(motion.scale);
 
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
+	cached.owner = entity;
+	cached.version = version;
+	cached.mat = transform.mat;
+	return cached.mat;
+}
+
+void RenderSystem::drawTexturedMesh(Entity entity,
+									const RenderRequest &render_request,
+									const Motion &motion,
+									const mat3 &projection)
+{
+	const mat3& transform = cachedTransform(entity, motion);
 
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
@@ -77,9 +112,8 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 		glActiveTexture(GL_TEXTURE0);
 		gl_has_errors();
 
-		assert(registry.renderRequests.has(entity));
 		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+			texture_gl_handles[(GLuint)render_request.used_texture];
 
 		glBindTexture(GL_TEXTURE_2D, texture_id);
 		gl_has_errors();
@@ -149,7 +183,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 	// Setting uniform values to the currently bound program
 	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
+	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform);
 	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
@@ -277,8 +311,10 @@ void RenderSystem::renderText(std::string text, float x, float y, float scale, c
 	}
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
-void RenderSystem::draw()
+void RenderSystem::draw(float alpha)
 {
+	this->alpha = alpha;
+
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
@@ -299,15 +335,10 @@ void RenderSystem::draw()
 							  // sprites back to front
 	gl_has_errors();
 	mat3 projection_2D = createProjectionMatrix();
-	// Draw all textured meshes that have a position and size component
-	for (Entity entity : registry.renderRequests.entities)
-	{
-		if (!registry.motions.has(entity))
-			continue;
-		// Note, its not very efficient to access elements indirectly via the entity
-		// albeit iterating through all Sprites in sequence. A good point to optimize
-		drawTexturedMesh(entity, projection_2D);
-	}
+	// Draw all textured meshes that have a position and size component, in the order the render requests were made
+	registry.view<RenderRequest, Motion>().ordered_by<RenderRequest>().read_only<RenderRequest, Motion>().each([&](Entity entity, RenderRequest& render_request, Motion& motion) {
+		drawTexturedMesh(entity, render_request, motion, projection_2D);
+	});
 	
 	if (registry.intro) {
 		float max_line_width = window_width_px * 0.7f; // 80% of screen width
@@ -11,6 +11,7 @@
 #include "common.hpp"
 #include "components.hpp"
 #include "tiny_ecs.hpp"
+#include "fixed_timestep.hpp"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -137,8 +138,14 @@ public:
 	// Destroy resources associated to one or all entities created by the system
 	~RenderSystem();
 
-	// Draw all entities
-	void draw();
+	// Draw all entities, alpha is the fraction of a simulation tick elapsed since the last one
+	void draw(float alpha = 1.f);
+
+	// Remembers where everything is before a simulation tick moves it, for the interpolation in draw()
+	void store_previous_motions();
+
+	// Where to draw the entity this frame: the motion blended between the last two ticks
+	Motion interpolated(Entity entity, const Motion& motion) const;
 
 	mat3 createProjectionMatrix();
 
@@ -159,8 +166,24 @@ public:
 	
 private:
 	// Internal drawing functions for each entity type
-	void drawTexturedMesh(Entity entity, const mat3& projection);
+	void drawTexturedMesh(Entity entity, const RenderRequest& render_request, const Motion& motion, const mat3& projection);
 	void drawToScreen();
+
+	// Model matrices by entity index, rebuilt only when the entity's Motion version changed
+	struct CachedTransform {
+		unsigned int owner = 0;
+		unsigned int version = 0;
+		mat3 mat;
+	};
+	std::vector<CachedTransform> transform_cache;
+	const mat3& cachedTransform(Entity entity, const Motion& motion);
+
+	// Motions of the previous simulation tick, draw() blends them with the current ones
+	MotionHistory motion_history;
+	// how far the frame is between the previous and the current tick, 0..1
+	float alpha = 1.f;
+	// for bodies that moved in the last tick, which are not cached
+	mat3 blended_transform;
 	std::string readShaderFile(const std::string& filepath);
 
 	// Window handle
@@ -13,6 +13,7 @@
 
 // This creates circular header inclusion, that is quite bad.
 #include "tiny_ecs_registry.hpp"
+#include "hull.hpp"
 
 // stlib
 #include <iostream>
@@ -290,6 +291,8 @@ void RenderSystem::initializeGlMeshes()
 			meshes[(int)geom_index].vertices,
 			meshes[(int)geom_index].vertex_indices,
 			meshes[(int)geom_index].original_size);
+		// precomputed once for the mesh collisions of PhysicsSystem
+		convex_hull(meshes[(int)geom_index].vertices, meshes[(int)geom_index].hull);
 
 		bindVBOandIBO(geom_index,
 			meshes[(int)geom_index].vertices, 
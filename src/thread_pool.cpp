@@ -0,0 +1,73 @@
+// internal
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned int num_workers)
+{
+	workers.reserve(num_workers);
+	for (unsigned int i = 0; i < num_workers; i++)
+		workers.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::run(unsigned int count, const std::function<void(unsigned int)>& job)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		job_count = count;
+		next_index = 0;
+		busy = (unsigned int)workers.size();
+		generation++;
+	}
+	wake.notify_all();
+	drain();
+
+	// the job is owned by the caller, so every worker has to be out of it before returning
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return busy == 0; });
+	this->job = nullptr;
+}
+
+void ThreadPool::drain()
+{
+	for (unsigned int i = next_index++; i < job_count; i = next_index++)
+		(*job)(i);
+}
+
+void ThreadPool::work()
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+		drain();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0)
+				done.notify_one();
+		}
+	}
+}
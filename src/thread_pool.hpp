@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops, e.g. the collision narrowphase in PhysicsSystem::step.
+// The thread calling run() works too, so a pool with 0 workers simply runs everything on the caller.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int num_workers = default_worker_count());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Threads that take part in run(), the workers and the caller
+	unsigned int concurrency() const { return (unsigned int)workers.size() + 1; }
+
+	// Calls job(index) for every index in [0, count) on any of the threads and returns when all are done.
+	// Jobs are picked in index order but may finish in any order, so each should write to its own output.
+	void run(unsigned int count, const std::function<void(unsigned int)>& job);
+
+	// One worker per core besides the calling thread
+	static unsigned int default_worker_count() { return std::max(1u, std::thread::hardware_concurrency()) - 1; }
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake; // a new batch of jobs or shutdown
+	std::condition_variable done; // all workers left the batch
+	const std::function<void(unsigned int)>* job = nullptr;
+	unsigned int job_count = 0;
+	std::atomic<unsigned int> next_index{ 0 };
+	unsigned int generation = 0; // batches started, workers wait for it to change
+	unsigned int busy = 0; // workers that did not finish the current batch yet
+	bool stopping = false;
+
+	void work();
+	// Runs jobs of the current batch until none are left
+	void drain();
+};
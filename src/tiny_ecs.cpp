@@ -1,5 +1,123 @@
 // internal
 #include "tiny_ecs.hpp"
 
+// stlib
+#include <atomic>
+#include <deque>
+#include <mutex>
+
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+namespace
+{
+	struct EntityAllocator
+	{
+		// Never-used indices are handed out lock-free, starting from 1 (entity 0 is the default initialization)
+		std::atomic<unsigned int> next_index{ 1 };
+
+		// Recycled indices, FIFO so that each slot's generation wraps around as late as possible
+		std::mutex mutex;
+		std::deque<unsigned int> free_indices;
+		std::atomic<size_t> free_count{ 0 };
+
+		// Current generation per index, guarded by the mutex. Indices past the end are still at generation 0.
+		std::vector<unsigned int> generations;
+
+		unsigned int generation_of(unsigned int index) const
+		{
+			return index < generations.size() ? generations[index] : 0;
+		}
+	};
+
+	// Function-local so that entities created during static initialization find it constructed
+	EntityAllocator& allocator()
+	{
+		static EntityAllocator instance;
+		return instance;
+	}
+}
+
+unsigned int Entity::create_id()
+{
+	EntityAllocator& a = allocator();
+	if (a.free_count.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(a.mutex);
+		if (!a.free_indices.empty())
+		{
+			unsigned int index = a.free_indices.front();
+			a.free_indices.pop_front();
+			a.free_count.store(a.free_indices.size(), std::memory_order_release);
+			return (a.generation_of(index) << INDEX_BITS) | index;
+		}
+	}
+
+	unsigned int index = a.next_index.fetch_add(1, std::memory_order_relaxed);
+	assert(index <= INDEX_MASK && "Ran out of entity indices");
+	return index;
+}
+
+void Entity::destroy(Entity e)
+{
+	if (e.index() == 0)
+		return;
+
+	EntityAllocator& a = allocator();
+	std::lock_guard<std::mutex> lock(a.mutex);
+	if (a.generation_of(e.index()) != e.generation())
+		return; // already destroyed, the handle is stale
+
+	if (e.index() >= a.generations.size())
+		a.generations.resize(e.index() + 1, 0);
+	a.generations[e.index()] = (e.generation() + 1) & GENERATION_MASK;
+	a.free_indices.push_back(e.index());
+	a.free_count.store(a.free_indices.size(), std::memory_order_release);
+}
+
+bool Entity::is_alive(Entity e)
+{
+	EntityAllocator& a = allocator();
+	if (e.index() == 0 || e.index() >= a.next_index.load(std::memory_order_relaxed))
+		return false;
+
+	std::lock_guard<std::mutex> lock(a.mutex);
+	return a.generation_of(e.index()) == e.generation();
+}
+
+// Tick 0 is never current, so a cached version of 0 always reads as out of date
+unsigned int ChangeTick::tick = 1;
+
+void Entity::save_allocator(Snapshot& s)
+{
+	EntityAllocator& a = allocator();
+	std::lock_guard<std::mutex> lock(a.mutex);
+	s.put(a.next_index.load());
+	s.put(a.free_indices.size());
+	for (unsigned int index : a.free_indices)
+		s.put(index);
+	s.put(a.generations.size());
+	s.write_block(a.generations.data(), a.generations.size() * sizeof(unsigned int));
+}
+
+void Entity::load_allocator(Snapshot& s)
+{
+	EntityAllocator& a = allocator();
+	std::lock_guard<std::mutex> lock(a.mutex);
+	unsigned int next_index;
+	s.get(next_index);
+	a.next_index.store(next_index);
+
+	size_t n;
+	s.get(n);
+	a.free_indices.clear();
+	for (size_t i = 0; i < n; i++)
+	{
+		unsigned int index;
+		s.get(index);
+		a.free_indices.push_back(index);
+	}
+	a.free_count.store(n, std::memory_order_release);
+
+	s.get(n);
+	const unsigned int* g = (const unsigned int*)s.read_block(n * sizeof(unsigned int));
+	a.generations.assign(g, g + n);
+}
@@ -1,25 +1,181 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
+#include <memory>
 #include <set>
 #include <functional>
 #include <typeindex>
+#include <typeinfo>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <assert.h>
 
+// A byte buffer that holds a complete copy of the ECS state, see ComponentRegistry::snapshot and restore.
+// It keeps its capacity, so once it has grown to fit the world, taking another snapshot does not allocate.
+class Snapshot
+{
+	std::vector<unsigned char> bytes;
+	size_t cursor = 0;
+
+	// Arrays start at this alignment, so that they can be copied out of the buffer directly
+	enum : size_t { BLOCK_ALIGN = 16 };
+	static size_t align(size_t at) { return (at + BLOCK_ALIGN - 1) & ~(size_t)(BLOCK_ALIGN - 1); }
+public:
+	Snapshot(size_t reserved_bytes = 0) { bytes.reserve(reserved_bytes); }
+
+	void begin_write() { bytes.clear(); }
+	void begin_read() { cursor = 0; }
+	size_t size() const { return bytes.size(); }
+
+	void write(const void* data, size_t n)
+	{
+		size_t at = bytes.size();
+		bytes.resize(at + n);
+		if (n > 0)
+			std::memcpy(&bytes[at], data, n);
+	}
+
+	void read(void* data, size_t n)
+	{
+		assert(cursor + n <= bytes.size() && "Reading past the end of the snapshot");
+		if (n > 0)
+			std::memcpy(data, &bytes[cursor], n);
+		cursor += n;
+	}
+
+	// An aligned array of trivially copyable values
+	void write_block(const void* data, size_t n)
+	{
+		bytes.resize(align(bytes.size()));
+		write(data, n);
+	}
+
+	// The next block, in place
+	const void* read_block(size_t n)
+	{
+		cursor = align(cursor);
+		assert(cursor + n <= bytes.size() && "Reading past the end of the snapshot");
+		const void* data = bytes.data() + cursor;
+		cursor += n;
+		return data;
+	}
+
+	template <typename T>
+	void put(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Use a snapshot_write hook for this type");
+		write(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void get(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Use a snapshot_read hook for this type");
+		read(&value, sizeof(T));
+	}
+};
+
 // Unique identifyer for all entities
+// A handle is 32 bits: the low INDEX_BITS select a slot, the high bits are the slot's generation.
+// Destroyed slots are recycled and their generation bumped, so old handles to them no longer match.
 class Entity
 {
 	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
+	static unsigned int create_id(); // thread-safe, see tiny_ecs.cpp
 public:
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
 	Entity()
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		id = create_id(); // index 0 is never handed out, it stays the default initialization
+	}
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+
+	unsigned int index() const { return id & INDEX_MASK; }
+	unsigned int generation() const { return id >> INDEX_BITS; }
+
+	// Releases the slot of e for re-use by new entities. Destroying a stale handle does nothing.
+	static void destroy(Entity e);
+	// False once e was destroyed, even if its slot now belongs to a newer entity
+	static bool is_alive(Entity e);
+
+	// The allocator state (free indices and generations), part of every registry snapshot
+	static void save_allocator(Snapshot& s);
+	static void load_allocator(Snapshot& s);
+};
+
+// Global change tick. Components that are written to are stamped with the current tick,
+// see ComponentContainer::version and changed_since. The main loop advances it once per frame.
+class ChangeTick
+{
+	static unsigned int tick;
+public:
+	static unsigned int current() { return tick; }
+	static void advance() { tick++; }
+};
+
+// One bit per registered component type
+typedef uint64_t ComponentMask;
+
+// The component types every entity has, as a bitmask indexed by the entity's index.
+// Kept up to date by the registered containers on insert/remove.
+class ComponentSignatures
+{
+	std::vector<ComponentMask> masks;
+	std::vector<unsigned int> owners; // the handle each mask belongs to, so that stale handles read an empty mask
+public:
+	ComponentMask get(Entity e) const
+	{
+		unsigned int i = e.index();
+		return (i < owners.size() && owners[i] == e) ? masks[i] : 0;
+	}
+
+	void set(Entity e, unsigned int bit)
+	{
+		unsigned int i = e.index();
+		if (i >= owners.size())
+		{
+			owners.resize(i + 1, 0);
+			masks.resize(i + 1, 0);
+		}
+		if (owners[i] != e)
+		{
+			owners[i] = e;
+			masks[i] = 0;
+		}
+		masks[i] |= ComponentMask(1) << bit;
+	}
+
+	void reset(Entity e, unsigned int bit)
+	{
+		unsigned int i = e.index();
+		if (i < owners.size() && owners[i] == e)
+			masks[i] &= ~(ComponentMask(1) << bit);
+	}
+
+	void save(Snapshot& s) const
+	{
+		s.put(owners.size());
+		s.write_block(owners.data(), owners.size() * sizeof(unsigned int));
+		s.write_block(masks.data(), masks.size() * sizeof(ComponentMask));
+	}
+
+	void load(Snapshot& s)
+	{
+		size_t n;
+		s.get(n);
+		const unsigned int* o = (const unsigned int*)s.read_block(n * sizeof(unsigned int));
+		owners.assign(o, o + n);
+		const ComponentMask* m = (const ComponentMask*)s.read_block(n * sizeof(ComponentMask));
+		masks.assign(m, m + n);
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
 };
 
 // Common interface to refer to all containers in the ECS registry
@@ -29,22 +185,220 @@ struct ContainerInterface
 	virtual size_t size() = 0;
 	virtual void remove(Entity e) = 0;
 	virtual bool has(Entity entity) = 0;
+	// Called once by the registry, afterwards the container keeps its bit in the entities' signatures
+	virtual void register_signature(ComponentSignatures* signatures, unsigned int bit) = 0;
+};
+
+// The entities of one container: a packed array of entities plus the sparse array from Entity index -> position in it.
+// Shared by the containers with a payload and the tag containers below.
+class SparseSet : public ContainerInterface
+{
+protected:
+	// The sparse array is split into fixed-size pages that are only allocated for id ranges in use.
+	// Lookups are two array reads; no hashing and no allocation (only insert may allocate a new page).
+	enum : unsigned int { SPARSE_PAGE_BITS = 10, SPARSE_PAGE_SIZE = 1u << SPARSE_PAGE_BITS, NO_INDEX = ~0u };
+	std::vector<std::unique_ptr<unsigned int[]>> sparse_pages;
+
+	// Set once the registry registered this container
+	ComponentSignatures* signatures = nullptr;
+	unsigned int signature_bit = 0;
+
+	// Returns the sparse slot of an entity, or nullptr if its page was never allocated
+	unsigned int* find_slot(unsigned int id) const
+	{
+		unsigned int page = id >> SPARSE_PAGE_BITS;
+		if (page >= sparse_pages.size() || !sparse_pages[page])
+			return nullptr;
+		return &sparse_pages[page][id & (SPARSE_PAGE_SIZE - 1)];
+	}
+
+	// Returns the sparse slot of an entity, allocating its page if needed
+	unsigned int& assure_slot(unsigned int id)
+	{
+		unsigned int page = id >> SPARSE_PAGE_BITS;
+		if (page >= sparse_pages.size())
+			sparse_pages.resize(page + 1);
+		if (!sparse_pages[page])
+		{
+			sparse_pages[page].reset(new unsigned int[SPARSE_PAGE_SIZE]);
+			std::fill_n(sparse_pages[page].get(), SPARSE_PAGE_SIZE, NO_INDEX);
+		}
+		return sparse_pages[page][id & (SPARSE_PAGE_SIZE - 1)];
+	}
+
+	// Position of e in entities, or NO_INDEX. A stale handle shares the index but not the generation.
+	unsigned int position_of(Entity e) const
+	{
+		unsigned int* slot = find_slot(e.index());
+		return (slot && *slot != NO_INDEX && entities[*slot] == e) ? *slot : NO_INDEX;
+	}
+
+	// Appends e to entities
+	void push(Entity e, bool check_for_duplicates)
+	{
+		// Usually, every entity should only have one instance of each component type
+		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+		assert(Entity::is_alive(e) && "Entity was already destroyed");
+
+		assure_slot(e.index()) = (unsigned int)entities.size();
+		entities.push_back(e);
+		if (signatures)
+			signatures->set(e, signature_bit);
+	}
+
+	// Moves the last entity to position cID and drops the last entry; the caller moves the payload the same way
+	void pop(Entity e, unsigned int cID)
+	{
+		entities[cID] = entities.back(); // the entity is only a single index, copy it.
+		*find_slot(entities.back().index()) = cID;
+		*find_slot(e.index()) = NO_INDEX;
+		entities.pop_back();
+		if (signatures)
+			signatures->reset(e, signature_bit);
+	}
+
+	void save_entities(Snapshot& s) const
+	{
+		s.put(entities.size());
+		s.write_block(entities.data(), entities.size() * sizeof(Entity));
+	}
+
+	// Replaces the entities by the ones in the snapshot. The registry restores the signatures afterwards.
+	size_t load_entities(Snapshot& s)
+	{
+		clear_entities();
+		size_t n;
+		s.get(n);
+		const Entity* e = (const Entity*)s.read_block(n * sizeof(Entity));
+		entities.assign(e, e + n); // copies, Entity() would allocate new handles
+		for (unsigned int i = 0; i < n; i++)
+			assure_slot(entities[i].index()) = i;
+		return n;
+	}
+
+	// Sorting works on a copy of entities, so that the comparison function can still look up components.
+	// Kept as a member to re-use its memory.
+	std::vector<Entity> sort_scratch;
+
+	// Sorts entities, the sparse array is left as is
+	template <class Compare>
+	void sort_entities(Compare comparisonFunction)
+	{
+		sort_scratch = entities;
+		std::sort(sort_scratch.begin(), sort_scratch.end(), comparisonFunction);
+		entities.swap(sort_scratch);
+	}
+
+	// Insertion sort of entities, the sparse array is left as is. Returns whether any entity moved.
+	template <class Compare>
+	bool insertion_sort_entities(Compare comparisonFunction)
+	{
+		sort_scratch = entities;
+		bool moved = false;
+		for (size_t i = 1; i < sort_scratch.size(); i++)
+		{
+			if (!comparisonFunction(sort_scratch[i], sort_scratch[i - 1]))
+				continue;
+			Entity e = sort_scratch[i];
+			size_t j = i;
+			for (; j > 0 && comparisonFunction(e, sort_scratch[j - 1]); j--)
+				sort_scratch[j] = sort_scratch[j - 1];
+			sort_scratch[j] = e;
+			moved = true;
+		}
+		if (moved)
+			entities.swap(sort_scratch);
+		return moved;
+	}
+
+	void clear_entities()
+	{
+		// Only the slots of contained entities can be set, so reset those instead of every page
+		for (Entity e : entities)
+		{
+			*find_slot(e.index()) = NO_INDEX;
+			if (signatures)
+				signatures->reset(e, signature_bit);
+		}
+		entities.clear();
+	}
+public:
+	// The entities that have this component
+	std::vector<Entity> entities;
+
+	// Check if entity has this component
+	bool has(Entity entity)
+	{
+		return position_of(entity) != NO_INDEX;
+	}
+
+	// Report the number of entities with this component
+	size_t size()
+	{
+		return entities.size();
+	}
+
+	void register_signature(ComponentSignatures* s, unsigned int bit)
+	{
+		assert(bit < sizeof(ComponentMask) * 8 && "Too many component types for ComponentMask");
+		signatures = s;
+		signature_bit = bit;
+	}
+
+	// The position of this component type in ComponentSignatures, valid once registered
+	unsigned int bit() const
+	{
+		assert(signatures && "Container is not registered");
+		return signature_bit;
+	}
+
+	// The bit of this component type in ComponentSignatures, valid once registered
+	ComponentMask mask() const
+	{
+		assert(signatures && "Container is not registered");
+		return ComponentMask(1) << signature_bit;
+	}
 };
 
 // A container that stores components of type 'Component' and associated entities
-template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+// Empty structs (tags) are detected at compile time and use the specialization below.
+template <typename Component, bool IsTag = std::is_empty<Component>::value> // A component can be any class
+class ComponentContainer : public SparseSet
 {
-private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
-	bool registered = false;
+	void save_components(Snapshot& s, std::true_type) const
+	{
+		s.write_block(components.data(), components.size() * sizeof(Component));
+	}
+
+	void save_components(Snapshot& s, std::false_type) const
+	{
+		for (const Component& c : components)
+			snapshot_write(s, c);
+	}
+
+	void load_components(Snapshot& s, size_t n, std::true_type)
+	{
+		const Component* c = (const Component*)s.read_block(n * sizeof(Component));
+		components.assign(c, c + n);
+	}
+
+	void load_components(Snapshot& s, size_t n, std::false_type)
+	{
+		components.reserve(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			Component c;
+			snapshot_read(s, c);
+			components.push_back(std::move(c));
+		}
+	}
 public:
 	// Container of all components of type 'Component'
+	// Writing through components[i] directly is not tracked, call mark_changed(i) afterwards.
 	std::vector<Component> components;
 
-	// The corresponding entities
-	std::vector<Entity> entities;
+	// The ChangeTick at which each component was inserted or last accessed for writing, parallel to components
+	std::vector<unsigned int> versions;
 
 	// Constructor that registers the type
 	ComponentContainer()
@@ -54,12 +408,10 @@ public:
 	// Inserting a component c associated to entity e
 	inline Component& insert(Entity e, Component c, bool check_for_duplicates = true)
 	{
-		// Usually, every entity should only have one instance of each component type
-		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
-
-		map_entity_componentID[e] = (unsigned int)components.size();
+		push(e, check_for_duplicates);
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
-		entities.push_back(e);
+		versions.push_back(ChangeTick::current());
+		modification_count++;
 		return components.back();
 	};
 
@@ -73,51 +425,113 @@ public:
 		return insert(e, Component(std::forward<Args>(args)...), false);
 	};
 
-	// A wrapper to return the component of an entity
+	// A wrapper to return the component of an entity, marks it as changed
 	Component& get(Entity e) {
-		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		unsigned int cID = position_of(e);
+		assert(cID != NO_INDEX && "Entity not contained in ECS registry");
+		versions[cID] = ChangeTick::current();
+		modification_count++;
+		return components[cID];
+	}
+
+	// Read-only access, does not mark the component as changed
+	const Component& peek(Entity e) const {
+		unsigned int cID = position_of(e);
+		assert(cID != NO_INDEX && "Entity not contained in ECS registry");
+		return components[cID];
+	}
+
+	// Returns the component of an entity, or nullptr if it has none. A single lookup instead of has() followed by get()
+	Component* try_get(Entity e) {
+		unsigned int cID = position_of(e);
+		if (cID == NO_INDEX)
+			return nullptr;
+		versions[cID] = ChangeTick::current();
+		modification_count++;
+		return &components[cID];
+	}
+
+	// As try_get, but without marking the component as changed; use mark_changed if it is written after all
+	Component* try_peek(Entity e) {
+		unsigned int cID = position_of(e);
+		return cID != NO_INDEX ? &components[cID] : nullptr;
+	}
+
+	// Marks components[i] as changed, for loops that write to the components vector directly
+	void mark_changed(size_t i) {
+		versions[i] = ChangeTick::current();
+		modification_count++;
+	}
+	void mark_changed(const Component* c) {
+		mark_changed(c - components.data());
+	}
+
+	// The tick at which the component of e was last written to
+	unsigned int version(Entity e) const {
+		unsigned int cID = position_of(e);
+		assert(cID != NO_INDEX && "Entity not contained in ECS registry");
+		return versions[cID];
+	}
+
+	// Counts the insertions, removals, reorderings and the writes that set a version. Caches over the whole container
+	// compare it to tell whether anything changed at all, which the versions can not within a tick.
+	unsigned int modifications() const { return modification_count; }
+
+	// Whether the component of e was written to at or after tick
+	bool changed_since(Entity e, unsigned int tick) const {
+		return version(e) >= tick;
 	}
 
-	// Check if entity has a component of type 'Component'
-	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+	// Calls f(Entity, Component&) for every component written to at or after tick, without marking it again
+	template <class Function>
+	void each_changed_since(unsigned int tick, Function f) {
+		for (size_t i = 0; i < components.size(); i++)
+			if (versions[i] >= tick)
+				f(entities[i], components[i]);
 	}
 
 	// Remove an component and pack the container to re-use the empty space
 	void remove(Entity e)
 	{
-		if (has(e))
+		unsigned int cID = position_of(e);
+		if (cID != NO_INDEX)
 		{
-			// Get the current position
-			int cID = map_entity_componentID[e];
-
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
-			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
-
-			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
 			components.pop_back();
-			entities.pop_back();
-			// Note, one could mark the id for re-use
+			versions[cID] = versions.back();
+			versions.pop_back();
+			pop(e, cID);
+			modification_count++;
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		clear_entities();
 		components.clear();
-		entities.clear();
+		versions.clear();
+		modification_count++;
 	}
 
-	// Report the number of components of type 'Component'
-	size_t size()
+	// Appends entities and components to s. Trivially copyable components are copied as one block,
+	// others are written one by one with their snapshot_write(Snapshot&, const Component&) hook.
+	void save(Snapshot& s) const
+	{
+		save_entities(s);
+		save_components(s, std::is_trivially_copyable<Component>());
+	}
+
+	// Replaces all components by the ones saved in s; they count as changed at the current tick
+	void load(Snapshot& s)
 	{
-		return components.size();
+		components.clear();
+		size_t n = load_entities(s);
+		load_components(s, n, std::is_trivially_copyable<Component>());
+		versions.assign(n, ChangeTick::current());
+		modification_count++;
 	}
 
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
@@ -125,13 +539,367 @@ public:
 	void sort(Compare comparisonFunction)
 	{
 		// First sort the entity list as desired
-		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
+		sort_entities(comparisonFunction);
+		// Now re-arrange the components, the sparse array still points at their old positions
+		permute_to_entities();
+	}
+
+	// The same for containers that are nearly sorted already (e.g. sorted every frame by draw order or x),
+	// an insertion sort that is O(n) when few entities changed place. Stable.
+	template <class Compare>
+	void sort_incremental(Compare comparisonFunction)
+	{
+		if (insertion_sort_entities(comparisonFunction))
+			permute_to_entities();
+	}
+
+private:
+	unsigned int modification_count = 0;
+
+	// Moves the components to the order of entities, in place by following the cycles of the permutation.
+	// The sparse array holds each component's old position and is updated as the components are placed.
+	void permute_to_entities()
+	{
+		modification_count++;
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+		{
+			unsigned int src = *find_slot(entities[i].index());
+			if (src == i)
+				continue; // in place, or placed as part of an earlier cycle
+
+			Component held = std::move(components[i]);
+			unsigned int held_version = versions[i];
+			unsigned int j = i;
+			while (src != i)
+			{
+				components[j] = std::move(components[src]);
+				versions[j] = versions[src];
+				*find_slot(entities[j].index()) = j;
+				j = src;
+				src = *find_slot(entities[j].index());
+			}
+			components[j] = std::move(held);
+			versions[j] = held_version;
+			*find_slot(entities[j].index()) = j;
+		}
+	}
+};
+
+// Tag components (empty structs such as Laser) only record which entities have them.
+// There is no payload vector, so adding costs no memory and removing moves no component.
+template <typename Component>
+class ComponentContainer<Component, true> : public SparseSet
+{
+	// All tags of a type are indistinguishable, get() hands out this one
+	static Component& instance()
+	{
+		static Component tag;
+		return tag;
+	}
+public:
+	inline Component& insert(Entity e, Component = Component(), bool check_for_duplicates = true)
+	{
+		push(e, check_for_duplicates);
+		return instance();
+	}
+
+	template<typename... Args>
+	Component& emplace(Entity e, Args &&... args) {
+		return insert(e, Component(std::forward<Args>(args)...));
+	};
+	template<typename... Args>
+	Component& emplace_with_duplicates(Entity e, Args &&... args) {
+		return insert(e, Component(std::forward<Args>(args)...), false);
+	};
+
+	Component& get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return instance();
+	}
+
+	Component* try_get(Entity e) {
+		return has(e) ? &instance() : nullptr;
+	}
+
+	// Tags have no data that could change
+	const Component& peek(Entity e) { return get(e); }
+	Component* try_peek(Entity e) { return try_get(e); }
+	void mark_changed(size_t) {}
+	void mark_changed(const Component*) {}
+
+	void remove(Entity e)
+	{
+		unsigned int cID = position_of(e);
+		if (cID != NO_INDEX)
+			pop(e, cID);
+	}
+
+	void clear()
+	{
+		clear_entities();
+	}
+
+	void save(Snapshot& s) const
+	{
+		save_entities(s);
+	}
+
+	void load(Snapshot& s)
+	{
+		load_entities(s);
+	}
+
+	// Tags carry no data, so only the entity order can be changed
+	template <class Compare>
+	void sort(Compare comparisonFunction)
+	{
+		sort_entities(comparisonFunction);
+		for (unsigned int i = 0; i < entities.size(); i++)
+			*find_slot(entities[i].index()) = i;
+	}
+
+	template <class Compare>
+	void sort_incremental(Compare comparisonFunction)
+	{
+		if (insertion_sort_entities(comparisonFunction))
+			for (unsigned int i = 0; i < entities.size(); i++)
+				*find_slot(entities[i].index()) = i;
+	}
+};
+
+// Position of T in the pack Ts
+template <typename T, typename... Ts> struct TypeIndex;
+template <typename T, typename... Ts> struct TypeIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+template <typename T, typename U, typename... Ts> struct TypeIndex<T, U, Ts...> : std::integral_constant<size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+// Joins several containers: visits every entity that has all of the requested components.
+// Iteration is driven by the smallest container and every other component is found by a sparse lookup,
+// so the cost scales with the rarest component. Components must not be added to or removed from the
+// joined containers inside each().
+// After f returns, the visited components are marked as changed, unless they are excluded with read_only<...>().
+// f may return a bool instead of void to say whether it wrote anything; false leaves the versions alone.
+template <typename... Components>
+class View
+{
+	std::tuple<ComponentContainer<Components>*...> containers;
+	std::vector<Entity>* driver;
+	bool tracked[sizeof...(Components)];
+
+	template <size_t... I>
+	void pick_smallest(std::index_sequence<I...>)
+	{
+		std::vector<Entity>* candidates[] = { &std::get<I>(containers)->entities... };
+		driver = candidates[0];
+		for (std::vector<Entity>* c : candidates)
+			if (c->size() < driver->size())
+				driver = c;
+	}
+
+	template <class Function, size_t... I>
+	void visit(Function& f, Entity e, std::index_sequence<I...>)
+	{
+		std::tuple<Components*...> found(std::get<I>(containers)->try_peek(e)...);
+		bool complete = true;
+		int unused[] = { (complete = complete && std::get<I>(found) != nullptr, 0)... };
+		if (!complete)
+			return;
+		(void)unused;
+		typedef decltype(f(e, *std::get<I>(found)...)) Result;
+		if (!call(f, std::is_same<Result, bool>(), e, *std::get<I>(found)...))
+			return;
+		int marked[] = { (tracked[I] ? std::get<I>(containers)->mark_changed(std::get<I>(found)) : (void)0, 0)... };
+		(void)marked;
+	}
+
+	// Returns whether f wrote to the components: what f returns, or always for a void f
+	template <class Function, typename... Found>
+	static bool call(Function& f, std::true_type, Entity e, Found&... found)
+	{
+		return f(e, found...);
+	}
+	template <class Function, typename... Found>
+	static bool call(Function& f, std::false_type, Entity e, Found&... found)
+	{
+		f(e, found...);
+		return true;
+	}
+public:
+	View(ComponentContainer<Components>&... c) : containers(&c...)
+	{
+		pick_smallest(std::index_sequence_for<Components...>());
+		std::fill_n(tracked, sizeof...(Components), true);
+	}
+
+	// Components that each() only reads, so they are not marked as changed
+	template <typename... ReadOnly>
+	View& read_only()
+	{
+		int unused[] = { (tracked[TypeIndex<ReadOnly, Components...>::value] = false, 0)... };
+		(void)unused;
+		return *this;
+	}
+
+	// Iterate in the order of one container instead, e.g. the draw order of render requests
+	template <typename Component>
+	View& ordered_by()
+	{
+		driver = &std::get<ComponentContainer<Component>*>(containers)->entities;
+		return *this;
+	}
+
+	// Calls f(Entity, Components&...) for every entity that has all components, see the marking rules above
+	template <class Function>
+	void each(Function f)
+	{
+		for (size_t i = 0; i < driver->size(); i++)
+			visit(f, (*driver)[i], std::index_sequence_for<Components...>());
+	}
+};
+
+// A list of component types, e.g. ComponentList<Motion, Player>
+template <typename... Components>
+struct ComponentList {};
+
+template <class List>
+class ComponentRegistry;
+
+// Owns one container per type of the list. The operations over all containers are expanded at compile time
+// over the tuple, so there are no virtual calls on these paths and no container can be left out.
+// The signature bit of a component type is its position in the list.
+template <typename... Components>
+class ComponentRegistry<ComponentList<Components...>>
+{
+	static_assert(sizeof...(Components) <= sizeof(ComponentMask) * 8, "Too many component types for ComponentMask");
+
+	std::tuple<ComponentContainer<Components>...> containers;
+
+	// Which containers each entity has a component in
+	ComponentSignatures signatures;
+
+	template <size_t... I>
+	void register_all(std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).register_signature(&signatures, (unsigned int)I), 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void remove_all(Entity e, ComponentMask mask, std::index_sequence<I...>)
+	{
+		int unused[] = { (((mask >> I) & 1) ? std::get<I>(containers).remove(e) : (void)0, 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void clear_all(std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).clear(), 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void save_all(Snapshot& s, std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).save(s), 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void load_all(Snapshot& s, std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).load(s), 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void list_all(std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).size() > 0 ?
+			printf("%4d components of type %s\n", (int)std::get<I>(containers).size(), typeid(Components).name()) : 0, 0)... };
+		(void)unused;
+	}
+
+	template <size_t... I>
+	void list_all_of(Entity e, std::index_sequence<I...>)
+	{
+		int unused[] = { (std::get<I>(containers).has(e) ? printf("type %s\n", typeid(Components).name()) : 0, 0)... };
+		(void)unused;
+	}
+public:
+	ComponentRegistry()
+	{
+		register_all(std::index_sequence_for<Components...>());
+	}
+
+	// The containers point at this registry's signatures
+	ComponentRegistry(const ComponentRegistry&) = delete;
+	ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+	// The container that stores components of type 'Component', e.g. container<Motion>()
+	template <typename Component>
+	ComponentContainer<Component>& container()
+	{
+		return std::get<ComponentContainer<Component>>(containers);
+	}
+
+	// Iterate over all entities that have every one of the given components, e.g. view<Gravity, Motion>().each(...)
+	template <typename... Queried>
+	View<Queried...> view()
+	{
+		return View<Queried...>(container<Queried>()...);
+	}
+
+	// Check with a single bit test whether e has all of the given components, e.g. has<Player, Gravity>(e)
+	template <typename... Queried>
+	bool has(Entity e)
+	{
+		ComponentMask required = 0;
+		int unused[] = { (required |= container<Queried>().mask(), 0)... };
+		(void)unused;
+		return (signatures.get(e) & required) == required;
+	}
+
+	// Removes every component of e and releases its handle, so that its index can be re-used by a new entity
+	// Only the containers in e's signature are visited.
+	void remove_all_components_of(Entity e)
+	{
+		remove_all(e, signatures.get(e), std::index_sequence_for<Components...>());
+		Entity::destroy(e);
+	}
+
+	void clear_all_components()
+	{
+		clear_all(std::index_sequence_for<Components...>());
+	}
+
+	// Copies every container, the signatures and the entity allocator into s, overwriting its content
+	void snapshot(Snapshot& s)
+	{
+		s.begin_write();
+		Entity::save_allocator(s);
+		save_all(s, std::index_sequence_for<Components...>());
+		signatures.save(s);
+	}
+
+	// Puts the ECS back into the state saved in s. Handles kept outside of the registry are only valid
+	// if they were valid when the snapshot was taken. Must not be called while commands are pending.
+	void restore(Snapshot& s)
+	{
+		s.begin_read();
+		Entity::load_allocator(s);
+		load_all(s, std::index_sequence_for<Components...>());
+		signatures.load(s);
+	}
+
+	void list_all_components()
+	{
+		printf("Debug info on all registry entries:\n");
+		list_all(std::index_sequence_for<Components...>());
+	}
+
+	void list_all_components_of(Entity e)
+	{
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		list_all_of(e, std::index_sequence_for<Components...>());
 	}
 };
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "tiny_ecs.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+
+// Prototype of archetype storage for entities that all have the same set of components, e.g. projectiles with
+// Motion, RenderRequest, Mesh* and Bullet. Only bench/archetype_bench uses it: ECSRegistry cannot store its
+// components here, and an entity does not move to another archetype when a component is added or removed. Instead of one ComponentContainer per type, each with its own order,
+// the entities are packed into fixed-size chunks that store one array per component (SoA),
+// so a query streams through contiguous memory without a lookup per entity and component.
+// Components are relocated with memcpy and therefore have to be trivially copyable.
+
+template <bool...> struct ArchetypeBoolPack;
+template <bool... B>
+using ArchetypeAllTrue = std::is_same<ArchetypeBoolPack<true, B...>, ArchetypeBoolPack<B..., true>>;
+
+inline constexpr size_t archetype_row_bytes(std::initializer_list<size_t> sizes)
+{
+	size_t bytes = 0;
+	for (size_t s : sizes)
+		bytes += s;
+	return bytes;
+}
+
+template <typename... Components>
+class Archetype
+{
+	static_assert(sizeof...(Components) > 0, "An archetype needs at least one component");
+	static_assert(ArchetypeAllTrue<std::is_trivially_copyable<Components>::value...>::value,
+		"Archetype components are moved with memcpy, they have to be trivially copyable");
+
+	enum : unsigned int { CHUNK_BYTES = 16 * 1024, NO_INDEX = ~0u };
+public:
+	// Entities per chunk, leaving room to align every array
+	enum : unsigned int {
+		CHUNK_CAPACITY = (unsigned int)((CHUNK_BYTES - alignof(std::max_align_t) * (sizeof...(Components) + 1)) /
+			archetype_row_bytes({ sizeof(Entity), sizeof(Components)... }))
+	};
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<unsigned char[]> memory;
+		Entity* entities;
+		std::tuple<Components*...> columns;
+		unsigned int count;
+	};
+
+	// Only the last chunk is partially filled, removal moves the very last entity into the hole
+	std::vector<Chunk> chunks;
+	// chunk * CHUNK_CAPACITY + row for each entity index, NO_INDEX if not stored here
+	std::vector<unsigned int> locations;
+	unsigned int total = 0;
+
+	template <typename T>
+	static T* carve(unsigned char*& cursor)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned archetype component");
+		uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + alignof(T) - 1) & ~(uintptr_t)(alignof(T) - 1);
+		cursor = reinterpret_cast<unsigned char*>(p + sizeof(T) * CHUNK_CAPACITY);
+		return reinterpret_cast<T*>(p);
+	}
+
+	static Chunk make_chunk()
+	{
+		Chunk chunk;
+		chunk.memory.reset(new unsigned char[CHUNK_BYTES]);
+		unsigned char* cursor = chunk.memory.get();
+		chunk.entities = carve<Entity>(cursor);
+		// braced initialization evaluates left to right, so the arrays are laid out in declaration order
+		chunk.columns = std::tuple<Components*...>{ carve<Components>(cursor)... };
+		assert(cursor <= chunk.memory.get() + CHUNK_BYTES);
+		chunk.count = 0;
+		return chunk;
+	}
+
+	unsigned int find(Entity e) const
+	{
+		unsigned int i = e.index();
+		if (i >= locations.size() || locations[i] == NO_INDEX)
+			return NO_INDEX;
+		unsigned int loc = locations[i];
+		return chunks[loc / CHUNK_CAPACITY].entities[loc % CHUNK_CAPACITY] == e ? loc : NO_INDEX;
+	}
+
+public:
+	void insert(Entity e, Components... components)
+	{
+		assert(!has(e) && "Entity already contained in archetype");
+		if (chunks.empty() || chunks.back().count == CHUNK_CAPACITY)
+			chunks.push_back(make_chunk());
+
+		Chunk& chunk = chunks.back();
+		unsigned int row = chunk.count++;
+		new (&chunk.entities[row]) Entity(e);
+		int unused[] = { (new (&std::get<Components*>(chunk.columns)[row]) Components(std::move(components)), 0)... };
+		(void)unused;
+
+		if (e.index() >= locations.size())
+			locations.resize(e.index() + 1, NO_INDEX);
+		locations[e.index()] = (unsigned int)(chunks.size() - 1) * CHUNK_CAPACITY + row;
+		total++;
+	}
+
+	bool has(Entity e) const { return find(e) != NO_INDEX; }
+
+	template <typename T>
+	T& get(Entity e)
+	{
+		unsigned int loc = find(e);
+		assert(loc != NO_INDEX && "Entity not contained in archetype");
+		return std::get<T*>(chunks[loc / CHUNK_CAPACITY].columns)[loc % CHUNK_CAPACITY];
+	}
+
+	void remove(Entity e)
+	{
+		unsigned int loc = find(e);
+		if (loc == NO_INDEX)
+			return;
+
+		Chunk& chunk = chunks[loc / CHUNK_CAPACITY];
+		unsigned int row = loc % CHUNK_CAPACITY;
+		Chunk& last = chunks.back();
+		unsigned int last_row = last.count - 1;
+		if (&chunk != &last || row != last_row)
+		{
+			// Fill the hole with the last entity, as ComponentContainer::remove does
+			Entity moved = last.entities[last_row];
+			std::memcpy((void*)&chunk.entities[row], (const void*)&last.entities[last_row], sizeof(Entity));
+			int unused[] = { (std::memcpy((void*)&std::get<Components*>(chunk.columns)[row],
+				(const void*)&std::get<Components*>(last.columns)[last_row], sizeof(Components)), 0)... };
+			(void)unused;
+			locations[moved.index()] = loc;
+		}
+		locations[e.index()] = NO_INDEX;
+		if (--last.count == 0)
+			chunks.pop_back();
+		total--;
+	}
+
+	void clear()
+	{
+		for (const Chunk& chunk : chunks)
+			for (unsigned int r = 0; r < chunk.count; r++)
+				locations[chunk.entities[r].index()] = NO_INDEX;
+		chunks.clear();
+		total = 0;
+	}
+
+	size_t size() const { return total; }
+
+	// Calls f(Entity, Queried&...) for every entity, e.g. each<Motion>(...) only touches the Motion arrays
+	template <typename... Queried, typename F>
+	void each(F f)
+	{
+		for (Chunk& chunk : chunks)
+			for (unsigned int r = 0; r < chunk.count; r++)
+				f(chunk.entities[r], std::get<Queried*>(chunk.columns)[r]...);
+	}
+
+	// Calls f(count, Entity*, Queried*...) once per chunk, for loops the compiler can vectorize
+	template <typename... Queried, typename F>
+	void each_chunk(F f)
+	{
+		for (Chunk& chunk : chunks)
+			f(chunk.count, chunk.entities, std::get<Queried*>(chunk.columns)...);
+	}
+};
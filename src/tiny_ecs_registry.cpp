@@ -1,3 +1,112 @@
 #include "tiny_ecs_registry.hpp"
 
-ECSRegistry registry;
\ No newline at end of file
+ECSRegistry registry;
+
+void snapshot_write(Snapshot& s, const Text& text)
+{
+	s.put(text.text.size());
+	s.write(text.text.data(), text.text.size());
+	s.put(text.position);
+	s.put(text.is_visible);
+}
+
+void snapshot_read(Snapshot& s, Text& text)
+{
+	size_t n;
+	s.get(n);
+	text.text.resize(n);
+	s.read(&text.text[0], n);
+	s.get(text.position);
+	s.get(text.is_visible);
+}
+
+void snapshot_write(Snapshot& s, const AnimationFrame& animation)
+{
+	s.put(animation.frames.size());
+	s.write(animation.frames.data(), animation.frames.size() * sizeof(TEXTURE_ASSET_ID));
+	s.put(animation.current_frame);
+	s.put(animation.frame_time);
+}
+
+void snapshot_read(Snapshot& s, AnimationFrame& animation)
+{
+	size_t n;
+	s.get(n);
+	animation.frames.resize(n);
+	s.read(animation.frames.data(), n * sizeof(TEXTURE_ASSET_ID));
+	s.get(animation.current_frame);
+	s.get(animation.frame_time);
+}
+
+void CommandBuffer::apply()
+{
+	for (const Command& c : commands)
+	{
+		switch (c.op)
+		{
+		case Op::DESTROY:
+			// destroying twice is harmless, the second handle is stale and has no components left
+			owner.remove_all_components_of(c.entity);
+			pending_destroys[c.entity.index()] = 0;
+			break;
+		case Op::ADD:
+			// skip components for entities that were destroyed before the flush
+			if (Entity::is_alive(c.entity))
+				c.adds->insert(c.add_index);
+			break;
+		case Op::REMOVE:
+			c.container->remove(c.entity);
+			break;
+		}
+	}
+	// keep the capacity of the arrays; only components that own memory themselves (e.g. Text) allocate when recorded
+	commands.clear();
+	for (auto& pending : pending_adds)
+		if (pending)
+			pending->clear();
+}
+
+std::atomic<unsigned int> ECSRegistry::next_serial(1);
+
+CommandBuffer& ECSRegistry::deferred()
+{
+	// The buffer this thread used last and its registry; the game records into a single registry,
+	// so the lookup below only runs once per thread
+	thread_local unsigned int cached_serial = 0;
+	thread_local CommandBuffer* cached_buffer = nullptr;
+	if (cached_serial == serial)
+		return *cached_buffer;
+
+	std::thread::id thread = std::this_thread::get_id();
+	std::lock_guard<std::mutex> lock(command_buffers_mutex);
+	size_t i = 0;
+	while (i < command_buffers.size() && command_buffer_threads[i] != thread)
+		i++;
+	if (i == command_buffers.size())
+	{
+		command_buffers.emplace_back(new CommandBuffer(*this));
+		command_buffer_threads.push_back(thread);
+	}
+	cached_serial = serial;
+	cached_buffer = command_buffers[i].get();
+	return *cached_buffer;
+}
+
+void ECSRegistry::flush_commands()
+{
+	std::lock_guard<std::mutex> lock(command_buffers_mutex);
+	for (auto& buffer : command_buffers)
+		if (!buffer->empty())
+			buffer->apply();
+}
+
+bool ECSRegistry::is_destroyed(Entity e)
+{
+	if (!Entity::is_alive(e))
+		return true;
+	std::lock_guard<std::mutex> lock(command_buffers_mutex);
+	for (auto& buffer : command_buffers)
+		if (buffer->is_destroyed(e))
+			return true;
+	return false;
+}
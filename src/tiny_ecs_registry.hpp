@@ -1,105 +1,198 @@
 
 #pragma once
 #include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 
-class ECSRegistry
+class ECSRegistry;
+
+// Records structural changes (create/destroy entities, add/remove components) while a system iterates,
+// so that they are applied in one batch at a sync point (ECSRegistry::flush_commands) instead of
+// invalidating the containers being walked. Each thread records into its own buffer, see ECSRegistry::deferred().
+class CommandBuffer
 {
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
+	// The components recorded by add() for one component type, stored by value so that recording is a copy
+	// into an array whose memory is kept between flushes
+	struct PendingAdds
+	{
+		virtual ~PendingAdds() {}
+		virtual void insert(unsigned int i) = 0;
+		virtual void clear() = 0;
+	};
+
+	template <typename Component>
+	struct TypedPendingAdds : PendingAdds
+	{
+		ComponentContainer<Component>* container;
+		std::vector<std::pair<Entity, Component>> adds;
+
+		TypedPendingAdds(ComponentContainer<Component>* container) : container(container) {}
+		void insert(unsigned int i) { container->insert(adds[i].first, std::move(adds[i].second)); }
+		void clear() { adds.clear(); }
+	};
+
+	enum class Op { DESTROY, ADD, REMOVE };
+	struct Command {
+		Op op;
+		Entity entity;
+		ContainerInterface* container; // REMOVE only
+		PendingAdds* adds; // ADD only
+		unsigned int add_index; // ADD only, into adds
+	};
+
+	ECSRegistry& owner;
+	std::vector<Command> commands;
+	// By signature bit of the component type, created on the first add() of that type
+	std::unique_ptr<PendingAdds> pending_adds[sizeof(ComponentMask) * 8];
+	// The handle of each entity whose destroy is pending, by entity index; 0 is never a handle.
+	// A recycled index has a different generation, so it does not match a newer entity.
+	std::vector<unsigned int> pending_destroys;
 
 public:
-	// Manually created list of all components this game has
-	// TODO: A1 add a LightUp component
-	ComponentContainer<DeathTimer> deathTimers;
-	ComponentContainer<Motion> motions;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Player> players;
-	ComponentContainer<Mesh*> meshPtrs;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<vec3> colors;
-	ComponentContainer<Block> blocks;
-	ComponentContainer<Gravity> gravities;
-	ComponentContainer<Bullet> bullets;
-	ComponentContainer<Grenade> grenades;
-	ComponentContainer<Explosion> explosions;
-	ComponentContainer<GunTimer> gunTimers;
-	ComponentContainer<StageChoice> stages;
-	ComponentContainer<Item> items;
-
-	ComponentContainer<AnimationFrame> animations;
-	ComponentContainer<Text> texts;
-	ComponentContainer<Background> backgrounds;
-
-	ComponentContainer<Portal> portals;
-  	ComponentContainer<Laser> lasers;
-	ComponentContainer<Laser2> lasers2;
-	ComponentContainer<Lifetime> lifetimes;
-	ComponentContainer<LightUp> lightUps;
+	CommandBuffer(ECSRegistry& owner) : owner(owner) {}
 
-	bool intro = true;
-	int winner = 0;
-	int stageSelection = 0;
+	// Handles are allocated immediately (this is thread safe), its components can be added with add()
+	Entity create() { return Entity(); }
 
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
-	ECSRegistry()
-	{
-		registry_list.push_back(&deathTimers);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&players);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&colors);
-		registry_list.push_back(&blocks);
-		registry_list.push_back(&gravities);
-		registry_list.push_back(&bullets);
-		registry_list.push_back(&gunTimers);
-		registry_list.push_back(&items);
-		registry_list.push_back(&grenades);
-		registry_list.push_back(&explosions);
-
-		registry_list.push_back(&animations);
-		registry_list.push_back(&texts);
-		registry_list.push_back(&backgrounds);
-
-		registry_list.push_back(&portals);
-    	registry_list.push_back(&lasers);
-		registry_list.push_back(&lasers2);
-		registry_list.push_back(&lifetimes);
-		registry_list.push_back(&lightUps);
+	void destroy(Entity e) {
+		if (e.index() >= pending_destroys.size())
+			pending_destroys.resize(e.index() + 1, 0);
+		pending_destroys[e.index()] = e;
+		commands.push_back({ Op::DESTROY, e, nullptr, nullptr, 0 });
 	}
 
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
-	}
+	template <typename Component>
+	void add(Entity e, Component c);
 
-	void list_all_components() {
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
+	template <typename Component>
+	void remove(Entity e);
 
-	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
+	// Whether a destroy of e has been recorded since the last flush, a single array read
+	bool is_destroyed(Entity e) const {
+		return e.index() < pending_destroys.size() && pending_destroys[e.index()] == e;
 	}
 
-	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
-	}
+	bool empty() const { return commands.empty(); }
+
+	// Applies the recorded commands in the order they were recorded
+	void apply();
+};
+
+// Snapshot hooks for the components that are not trivially copyable, see ComponentContainer::save
+void snapshot_write(Snapshot& s, const Text& text);
+void snapshot_read(Snapshot& s, Text& text);
+void snapshot_write(Snapshot& s, const AnimationFrame& animation);
+void snapshot_read(Snapshot& s, AnimationFrame& animation);
+
+// All component types this game has; the position in the list is the signature bit of the type
+typedef ComponentList<
+	DeathTimer,
+	Motion,
+	Collision,
+	Player,
+	Inventory,
+	Mesh*,
+	RenderRequest,
+	ScreenState,
+	DebugComponent,
+	vec3,
+	Block,
+	Gravity,
+	Bullet,
+	GunTimer,
+	Item,
+	Grenade,
+	Explosion,
+	StageChoice,
+	AnimationFrame,
+	Text,
+	Background,
+	Portal,
+	Laser,
+	Laser2,
+	Lifetime,
+	LightUp,
+	PhysicsBody,
+	FastMover
+> GameComponents;
+
+class ECSRegistry : public ComponentRegistry<GameComponents>
+{
+	// One command buffer per thread that recorded something, applied together by flush_commands()
+	std::vector<std::unique_ptr<CommandBuffer>> command_buffers;
+	// The thread that records into each of command_buffers
+	std::vector<std::thread::id> command_buffer_threads;
+	std::mutex command_buffers_mutex;
+
+	// Identifies the registry in the threads' cached buffers; never reused, unlike the address of a destroyed registry
+	static std::atomic<unsigned int> next_serial;
+	const unsigned int serial = next_serial++;
+
+public:
+	// Named access to the containers of GameComponents
+	ComponentContainer<DeathTimer>& deathTimers = container<DeathTimer>();
+	ComponentContainer<Motion>& motions = container<Motion>();
+	ComponentContainer<Collision>& collisions = container<Collision>();
+	ComponentContainer<Player>& players = container<Player>();
+	ComponentContainer<Inventory>& inventories = container<Inventory>();
+	ComponentContainer<Mesh*>& meshPtrs = container<Mesh*>();
+	ComponentContainer<RenderRequest>& renderRequests = container<RenderRequest>();
+	ComponentContainer<ScreenState>& screenStates = container<ScreenState>();
+	ComponentContainer<DebugComponent>& debugComponents = container<DebugComponent>();
+	ComponentContainer<vec3>& colors = container<vec3>();
+	ComponentContainer<Block>& blocks = container<Block>();
+	ComponentContainer<Gravity>& gravities = container<Gravity>();
+	ComponentContainer<Bullet>& bullets = container<Bullet>();
+	ComponentContainer<Grenade>& grenades = container<Grenade>();
+	ComponentContainer<Explosion>& explosions = container<Explosion>();
+	ComponentContainer<GunTimer>& gunTimers = container<GunTimer>();
+	ComponentContainer<StageChoice>& stages = container<StageChoice>();
+	ComponentContainer<Item>& items = container<Item>();
+
+	ComponentContainer<AnimationFrame>& animations = container<AnimationFrame>();
+	ComponentContainer<Text>& texts = container<Text>();
+	ComponentContainer<Background>& backgrounds = container<Background>();
+
+	ComponentContainer<Portal>& portals = container<Portal>();
+	ComponentContainer<Laser>& lasers = container<Laser>();
+	ComponentContainer<Laser2>& lasers2 = container<Laser2>();
+	ComponentContainer<Lifetime>& lifetimes = container<Lifetime>();
+	ComponentContainer<LightUp>& lightUps = container<LightUp>();
+	ComponentContainer<PhysicsBody>& physicsBodies = container<PhysicsBody>();
+	ComponentContainer<FastMover>& fastMovers = container<FastMover>();
+
+	bool intro = true;
+	int winner = 0;
+	int stageSelection = 0;
+
+	// The calling thread's command buffer, use it to destroy entities or add/remove components while iterating
+	CommandBuffer& deferred();
+
+	// Sync point: applies all recorded commands of every thread, must not be called while a system is iterating
+	void flush_commands();
+
+	// Whether e is destroyed already or its destruction is pending in one of the command buffers
+	bool is_destroyed(Entity e);
 };
 
+template <typename Component>
+void CommandBuffer::add(Entity e, Component c) {
+	ComponentContainer<Component>& container = owner.container<Component>();
+	std::unique_ptr<PendingAdds>& pending = pending_adds[container.bit()];
+	if (!pending)
+		pending.reset(new TypedPendingAdds<Component>(&container));
+	std::vector<std::pair<Entity, Component>>& adds = static_cast<TypedPendingAdds<Component>*>(pending.get())->adds;
+	commands.push_back({ Op::ADD, e, nullptr, pending.get(), (unsigned int)adds.size() });
+	adds.emplace_back(e, std::move(c));
+}
+
+template <typename Component>
+void CommandBuffer::remove(Entity e) {
+	commands.push_back({ Op::REMOVE, e, &owner.container<Component>(), nullptr, 0 });
+}
+
 extern ECSRegistry registry;
\ No newline at end of file
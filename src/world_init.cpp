@@ -9,10 +9,13 @@ Entity createPlayer(RenderSystem* renderer, int side, vec2 position, bool direct
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
     registry.meshPtrs.emplace(entity, &mesh);
 
-    auto& player = registry.players.emplace(entity);
+    Player player;
     player.side = side;
     player.direction = direction; // Default to facing right initially
+    registry.players.insert(entity, player);
+    registry.inventories.emplace(entity);
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::PLAYER });
     auto& motion = registry.motions.emplace(entity);
      motion.velocity = { 0, 0 }; 
      motion.position = position;
@@ -63,6 +66,7 @@ Entity createPortal(RenderSystem* renderer, vec2 position, int width, int height
     portal.width = width;
     portal.height = height;
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::PORTAL });
     auto& motion = registry.motions.emplace(entity);
      motion.velocity = { 0, 0 };
      motion.position = {position[0] - (width / 2), position[1] - (height / 2)};
@@ -84,6 +88,7 @@ Entity createGun(RenderSystem* renderer, int side, vec2 position) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::NONE });
 	auto& motion = registry.motions.emplace(entity);
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -111,6 +116,7 @@ Entity createIntro(RenderSystem* renderer, int width, int height) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::NONE });
 	auto& motion = registry.motions.emplace(entity);
 	motion.velocity = {0,0};
 	motion.position = {width / 2, height / 2};
@@ -130,6 +136,7 @@ Entity createBackground(RenderSystem* renderer, int width, int height) {
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
     registry.meshPtrs.emplace(entity, &mesh);
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::NONE });
     auto& motion = registry.motions.emplace(entity);
      motion.velocity = { 0, 0 };
      motion.position = {width / 2, height / 2};
@@ -213,6 +220,7 @@ Entity createStageChoice(RenderSystem* renderer, int x, int y, int width, int he
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
     registry.meshPtrs.emplace(entity, &mesh);
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::NONE });
     auto& motion = registry.motions.emplace(entity);
     auto& stageChoice = registry.stages.emplace(entity);
 
@@ -285,6 +293,7 @@ Entity createBlock1(RenderSystem* renderer, int x, int y, int width, int height)
 	block.height = height;
 
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::BLOCK });
 	auto& motion = registry.motions.emplace(entity);
  	motion.velocity = { 0.f, 0.f };
  	motion.position = {x + (width / 2), y + (height / 2)};
@@ -334,6 +343,7 @@ Entity createBlock2(RenderSystem* renderer, vec2 position, int width, int height
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
+	registry.physicsBodies.insert(entity, { moving ? BODY_TYPE::KINEMATIC : BODY_TYPE::STATIC, COLLISION_LAYER::BLOCK });
 	auto& motion = registry.motions.emplace(entity);
 	if (moving == 1) motion.velocity = { 80.f, 0.f };
 	else if (moving == 2) motion.velocity = { 0.f, 80.f };
@@ -390,6 +400,7 @@ Entity createHelpPanel(RenderSystem* renderer, int width, int height) {
     Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
     registry.meshPtrs.emplace(entity, &mesh);
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::STATIC, COLLISION_LAYER::NONE });
     auto& motion = registry.motions.emplace(entity);
     motion.velocity = { 0, 0 };
     motion.position = {width / 2, height / 2};
@@ -421,9 +432,10 @@ Entity createBullet(RenderSystem* renderer, int side, vec2 position, int directi
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SQUARE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& bullet = registry.bullets.emplace(entity);
-	bullet.side = side;
+	registry.bullets.insert(entity, { side });
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::BULLET });
+	registry.fastMovers.emplace(entity);
 	auto& motion = registry.motions.emplace(entity);
 	int dir = 0;
 	if (direction == 0) dir = -1;
@@ -453,17 +465,15 @@ std::vector<Entity> createBuckshot(RenderSystem* renderer, int side, vec2 positi
 	registry.meshPtrs.emplace(entity3, &mesh);
 	registry.meshPtrs.emplace(entity4, &mesh);
 
-	auto& bullet1 = registry.bullets.emplace(entity);
-	bullet1.side = side;
-
-	auto& bullet2 = registry.bullets.emplace(entity2);
-	bullet2.side = side;
-
-	auto& bullet3 = registry.bullets.emplace(entity3);
-	bullet3.side = side;
-
-	auto& bullet4 = registry.bullets.emplace(entity4);
-	bullet4.side = side;
+	registry.bullets.insert(entity, { side });
+	registry.bullets.insert(entity2, { side });
+	registry.bullets.insert(entity3, { side });
+	registry.bullets.insert(entity4, { side });
+	for (Entity e : { entity, entity2, entity3, entity4 })
+	{
+		registry.physicsBodies.insert(e, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::BULLET });
+		registry.fastMovers.emplace(e);
+	}
 
 
 	auto& motion = registry.motions.emplace(entity);
@@ -535,6 +545,7 @@ Entity createLaser(RenderSystem* renderer) {
     vec2 position = {distX(rng), distY(rng)};
 
     // Set the motion properties
+    registry.physicsBodies.insert(entity, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::NONE });
     auto& motion = registry.motions.emplace(entity);
     motion.position = position;
     motion.scale = {128,128}; // Scale the laser appropriately
@@ -552,6 +563,7 @@ Entity createLaserBeam(vec2 start, vec2 target) {
     float beamLength = length(target - start);
 
     // Set up the beam's motion properties
+    registry.physicsBodies.insert(beam, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::NONE });
     Motion& motion = registry.motions.emplace(beam);
     motion.position = midpoint;
     motion.scale = {25.f, beamLength};  // Width = 25.f, Length = beamLength
@@ -579,6 +591,7 @@ Entity createRandomItem(RenderSystem* renderer, Motion motion) {
     std::uniform_int_distribution<int> dist(0, 2);
     item.id = dist(rng);
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::ITEM });
 	Motion& item_motion = registry.motions.emplace(entity);
 	item_motion = motion;
 
@@ -609,9 +622,10 @@ Entity createRandomItem(RenderSystem* renderer, Motion motion) {
 
 Entity createGrenade(RenderSystem* renderer, vec2 position, int direction, int side) {
 	auto entity = Entity();
-	Grenade& grenade = registry.grenades.emplace(entity);
-	grenade.side = side;
+	registry.grenades.insert(entity, { side });
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::DYNAMIC, COLLISION_LAYER::GRENADE });
+	registry.fastMovers.emplace(entity);
 	auto& motion = registry.motions.emplace(entity);
 	int dir = 0;
 	if (direction == 0) dir = -1;
@@ -635,6 +649,7 @@ Entity createExplosion(vec2 position) {
 	auto entity = Entity();
 	registry.explosions.emplace(entity);
 
+	registry.physicsBodies.insert(entity, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::NONE });
 	auto& motion = registry.motions.emplace(entity);
  	motion.position = position;
 	motion.scale = { 300, 248 }; // width * height
@@ -657,6 +672,7 @@ Entity createLaserBeam2(vec2 start, int direction, int side) {
 
 	vec2 target = {start.x + dir * 1210, start.y};
 	vec2 midpoint = (start + target) * 0.5f;
+	registry.physicsBodies.insert(beam, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::NONE });
 	Motion& motion = registry.motions.emplace(beam);
     motion.position = midpoint;
 
@@ -679,6 +695,7 @@ Entity createSpecificItem(RenderSystem* renderer, Motion motion, int itemID) {
     Item& item = registry.items.emplace(entity);
     item.id = itemID;
 
+    registry.physicsBodies.insert(entity, { BODY_TYPE::KINEMATIC, COLLISION_LAYER::ITEM });
     Motion& item_motion = registry.motions.emplace(entity);
     item_motion = motion;
 
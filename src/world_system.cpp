@@ -236,9 +236,10 @@ GLFWwindow *WorldSystem::create_window()
 	return window;
 }
 
-void WorldSystem::init(RenderSystem *renderer_arg)
+void WorldSystem::init(RenderSystem *renderer_arg, PhysicsSystem *physics_arg)
 {
 	this->renderer = renderer_arg;
+	this->physics = physics_arg;
 
 	// Load high score from file
 	loadMatchRecords();
@@ -250,21 +251,15 @@ void WorldSystem::init(RenderSystem *renderer_arg)
 	restart_game();
 }
 
-// Update our game world
-bool WorldSystem::step(float elapsed_ms_since_last_update)
+// Counts rendered frames for the FPS display, the simulation itself runs in fixed ticks (see main.cpp)
+void WorldSystem::count_frame(float elapsed_ms)
 {
 	static float total_time = 0.0f;
     static int frame_count = 0;
 
-    total_time += elapsed_ms_since_last_update;
+    total_time += elapsed_ms;
     frame_count++;
 
-	// updating the timer for printing text.
-	toogle_life_timer -= elapsed_ms_since_last_update;
-	time_since_last_frame = elapsed_ms_since_last_update;
-	// std::cout << std::to_string(rounds) << std::endl;
-	// std::cout << std::to_string(num_p1_wins) << std::endl;
-
     if (total_time > 1000.0f) {
         fps = frame_count / (total_time / 1000.0f);
 		std::stringstream title_ss;
@@ -274,6 +269,16 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
         total_time = 0.0f;
         frame_count = 0;
     }
+}
+
+// Update our game world
+bool WorldSystem::step(float elapsed_ms_since_last_update)
+{
+	// updating the timer for printing text.
+	toogle_life_timer -= elapsed_ms_since_last_update;
+	time_since_last_frame = elapsed_ms_since_last_update;
+	// std::cout << std::to_string(rounds) << std::endl;
+	// std::cout << std::to_string(num_p1_wins) << std::endl;
 
 	// Only execute this logic in Stage 6 (Tutorial Mode)
 	if (registry.stageSelection == 6) {
@@ -356,6 +361,9 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 		// Removing out of screen entities
 		auto &motions_registry = registry.motions;
+
+		// Structural changes while walking the containers below are recorded and applied at the next flush
+		CommandBuffer& commands = registry.deferred();
 	
 		// Decrease cooldown timer each frame
 		if (laserCoolDownTimer > 0) {
@@ -372,28 +380,26 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 			if (laserCoolDownTimer <= 0 && isPlayerInRange()) {
 				laserCoolDownTimer = 3000;  // 3-second coolDown after attacking
 			}
-			for (Entity entity : registry.lifetimes.entities) {
-			Lifetime& lifetime = registry.lifetimes.get(entity);
+			for (uint i = 0; i < registry.lifetimes.size(); i++) {
+			Lifetime& lifetime = registry.lifetimes.components[i];
 			lifetime.counter_ms -= elapsed_ms_since_last_update;
 
 			// Remove the entity when its lifetime expires
 			if (lifetime.counter_ms <= 0) {
-				registry.remove_all_components_of(entity);
+				commands.destroy(registry.lifetimes.entities[i]);
 			}
 		}
 		}
 
-		for (Entity entity : registry.lightUps.entities) {
+		for (uint i = 0; i < registry.lightUps.size(); i++) {
 			// progress timer
-			if (registry.lightUps.has(entity)) {
-				LightUp& counter = registry.lightUps.get(entity);
-				counter.counter_ms -= elapsed_ms_since_last_update;
+			LightUp& counter = registry.lightUps.components[i];
+			counter.counter_ms -= elapsed_ms_since_last_update;
 
-				// remove the light up effect once the timer expired
-				if (counter.counter_ms < 0) {
-					registry.lightUps.remove(entity);
-				}
-			} 
+			// remove the light up effect once the timer expired
+			if (counter.counter_ms < 0) {
+				commands.remove<LightUp>(registry.lightUps.entities[i]);
+			}
 		}
 
 		// Update player1's position and enforce boundaries
@@ -442,24 +448,25 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 
 		// Remove entities that leave the screen on the left/right side
-		// Iterate backwards to be able to remove without unterfering with the next object to visit
-		// (the containers exchange the last element with the current)
-		for (int i = (int)motions_registry.components.size() - 1; i >= 0; --i)
+		// The removal is deferred to the next flush, entities created in here (explosions) are not visited.
+		// Copies, explode() emplaces into motions_registry and may move its components.
+		const uint num_motions = (uint)motions_registry.components.size();
+		for (uint i = 0; i < num_motions; i++)
 		{
-			Motion &motion = motions_registry.components[i];
+			const vec2 position = motions_registry.components[i].position;
+			const vec2 scale = motions_registry.components[i].scale;
 			Entity entity = motions_registry.entities[i];
-			if (motion.position.x + abs(motion.scale.x) < 0.f || motion.position.x - abs(motion.scale.x) > window_width_px)
+			if (position.x + abs(scale.x) < 0.f || position.x - abs(scale.x) > window_width_px)
 			{
 				if (!registry.players.has(entity)) {
 					if (registry.grenades.has(entity)) {
-						createExplosion(motion.position);
-						Mix_PlayChannel(-1, explosion_sound, 0);
+						explode(position);
 					}
-					registry.remove_all_components_of(entity);
+					commands.destroy(entity);
 				}
 			}
 
-			if (motion.position.y - abs(motion.scale.y) > window_height_px)
+			if (position.y - abs(scale.y) > window_height_px)
 			{
 				if (registry.players.has(entity)) {
 					Player& player = registry.players.get(entity);
@@ -503,6 +510,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 							num_p2_wins = 0;
 							item_toogle = false;
 							restart_game();
+							// all motions were replaced, stop iterating over the old ones
+							return true;
 						}
 					}
 					// registry.remove_all_components_of(motions_registry.entities[i]);	
@@ -528,9 +537,11 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 				item_motion.scale = {30, 45};
 
 				restart_flag = false;
-				for (int i = (int)motions_registry.components.size() - 1; i >= 0; --i) {
-					Motion &motion = motions_registry.components[i];
-					if (collides(item_motion, motion) && !registry.bullets.has(motions_registry.entities[i]) && !registry.backgrounds.has(motions_registry.entities[i])) {
+				// anything but bullets and the background in the way
+				BroadphaseBox item_box = bounding_box(item_motion);
+				physics->overlap_aabb(item_box.min, item_box.max, ~layer_bit(COLLISION_LAYER::BULLET), query_results);
+				for (Entity entity : query_results) {
+					if (!registry.backgrounds.has(entity)) {
 						restart_flag = true;
 						break;
 					}
@@ -558,7 +569,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 			// restart the game once the death timer expired
 			if (counter.counter_ms < 0)
 			{
-				int side = registry.players.get(entity).side;
+				int side = registry.players.peek(entity).side;
 				if (side == 2)
 					std::cout << "Red Player Wins" << std::endl; // Red Wins
 				else
@@ -576,13 +587,13 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 		// reduce window brightness if the salmon is dying
 		screen.darken_screen_factor = 1 - min_counter_ms / 3000;
 
-		for (Entity entity : registry.gunTimers.entities)
+		for (uint i = 0; i < registry.gunTimers.size(); i++)
 		{
-			GunTimer &counter = registry.gunTimers.get(entity);
+			GunTimer &counter = registry.gunTimers.components[i];
 			counter.counter_ms -= elapsed_ms_since_last_update;
 			if (counter.counter_ms < 0)
 			{
-				registry.gunTimers.remove(entity);
+				commands.remove<GunTimer>(registry.gunTimers.entities[i]);
 			}
 		}
 
@@ -698,6 +709,9 @@ void WorldSystem::restart_game() {
 // Compute collisions between entities
 void WorldSystem::handle_collisions()
 {
+	// Entities are destroyed at the next flush, so the collisions container stays intact while it is walked
+	CommandBuffer& commands = registry.deferred();
+
 	// Loop over all collisions detected by the physics system
 	auto &collisionsRegistry = registry.collisions;
 	for (uint i = 0; i < collisionsRegistry.components.size(); i++)
@@ -707,10 +721,14 @@ void WorldSystem::handle_collisions()
 		Entity entity_other = collisionsRegistry.components[i].other;
 		int direction = collisionsRegistry.components[i].direction;
 
+		// An earlier collision already consumed one of the two (e.g. a grenade that exploded)
+		if (commands.is_destroyed(entity) || commands.is_destroyed(entity_other))
+			continue;
+
 		if (registry.players.has(entity) && registry.blocks.has(entity_other)) {
 			Motion& motion = registry.motions.get(entity);
-			Block& block = registry.blocks.get(entity_other);
-			Motion& motion_block = registry.motions.get(entity_other);
+			const Block& block = registry.blocks.peek(entity_other);
+			const Motion& motion_block = registry.motions.peek(entity_other);
 			Player& player = registry.players.get(entity);
 			if (direction == 1) { // top collision
 				if (motion.velocity[1] >= 0.0f) {
@@ -729,12 +747,12 @@ void WorldSystem::handle_collisions()
 		}
 
 		// add collision between blocks & bullets such that bullets should disappear when colliding with the block
-		if (registry.blocks.has(entity) && registry.bullets.has(entity_other)) registry.remove_all_components_of(entity_other);
+		if (registry.blocks.has(entity) && registry.bullets.has(entity_other)) commands.destroy(entity_other);
 
 		if (registry.players.has(entity) && registry.bullets.has(entity_other))
 		{	
 			Player &player = registry.players.get(entity);
-			if (player.side != registry.bullets.get(entity_other).side)
+			if (player.side != registry.bullets.peek(entity_other).side)
 			{
 				if (player.health != 0) {
 					if (registry.stageSelection != 6) {
@@ -775,7 +793,7 @@ void WorldSystem::handle_collisions()
 						// the player won wins more rounds will be the victor: num_p2_wins = rounds - num_p1_wins;
 
 					}
-					registry.remove_all_components_of(entity_other);
+					commands.destroy(entity_other);
 				}
 			}
 		}
@@ -784,17 +802,16 @@ void WorldSystem::handle_collisions()
 		if (registry.portals.has(entity) && (registry.bullets.has(entity_other) || registry.grenades.has(entity_other) || registry.players.has(entity_other)))
 		{
 			// updated behaviour such that bullets can be teleported too
-			Portal &portal = registry.portals.get(entity);
-			Motion &motion_portal1 = registry.motions.get(portal1);
+			const Motion &motion_portal1 = registry.motions.peek(portal1);
 			Motion &motion_bullet = registry.motions.get(entity_other);
-			Motion &motion_portal2 = registry.motions.get(portal2);
+			const Motion &motion_portal2 = registry.motions.peek(portal2);
 			float offset;
 			if (registry.bullets.has(entity_other)) offset = 35;
 			else if (registry.grenades.has(entity_other)) offset = 50;
 			else offset = 65;
 			Mix_PlayChannel(-1, portal_sound, 0);
 			// since there are just 2 portals
-			if (portal.x ==  registry.portals.get(portal1).x && portal.y == registry.portals.get(portal1).y)
+			if (entity == portal1)
 			{
 				// teleport player to the pos of portal2
 				if (motion_bullet.velocity.x >= 0) motion_bullet.position = {motion_portal2.position.x + offset, motion_portal2.position.y + (motion_bullet.position.y - motion_portal1.position.y)};
@@ -815,27 +832,26 @@ void WorldSystem::handle_collisions()
 
 		if (registry.bullets.has(entity) && registry.bullets.has(entity_other))
 		{
-			if (registry.bullets.get(entity).side != registry.bullets.get(entity_other).side) {
-				registry.remove_all_components_of(entity);
-				registry.remove_all_components_of(entity_other);
+			if (registry.bullets.peek(entity).side != registry.bullets.peek(entity_other).side) {
+				commands.destroy(entity);
+				commands.destroy(entity_other);
 			}
 		}
 
 		
 		if (registry.players.has(entity) && registry.items.has(entity_other))
 		{
-			Player &player = registry.players.get(entity);
-			Item item = registry.items.get(entity_other);
+			Inventory &inventory = registry.inventories.get(entity);
+			Item item = registry.items.peek(entity_other);
 
 			// Allow the player to pick up the item
-			if (player.items.size() == 3) {
-				player.items.pop();
+			if (inventory.items.full()) {
+				inventory.items.pop();
 			}
-			player.items.push(item);
+			inventory.items.push(item);
 
 			// Remove the item from the registry
-			registry.items.remove(entity_other);
-			registry.remove_all_components_of(entity_other);
+			commands.destroy(entity_other);
 
 			// If we're in Stage 4, update the ItemSpawnInfo
 			if (registry.stageSelection == 6) {
@@ -856,95 +872,27 @@ void WorldSystem::handle_collisions()
 
 		if ((registry.players.has(entity) || registry.blocks.has(entity)) && registry.grenades.has(entity_other))
         {
-            if ((registry.players.has(entity) && registry.players.get(entity).side != registry.grenades.get(entity_other).side) || registry.blocks.has(entity)) {
-                Motion& motion = registry.motions.get(entity_other);
-                createExplosion(motion.position);
-				Mix_PlayChannel(-1, explosion_sound, 0);
-                registry.remove_all_components_of(entity_other);
+            if ((registry.players.has(entity) && registry.players.peek(entity).side != registry.grenades.peek(entity_other).side) || registry.blocks.has(entity)) {
+                explode(registry.motions.peek(entity_other).position);
+                commands.destroy(entity_other);
             } 
         }
-
-        if (registry.players.has(entity) && registry.explosions.has(entity_other))
-        {	
-            Explosion& explosion = registry.explosions.get(entity_other);
-			Player& player = registry.players.get(entity);
-			int side = player.side;
-			bool player_damagable;
-			if (side == 1) player_damagable = explosion.damagable1;
-			else player_damagable = explosion.damagable2;
-
-            if (player_damagable) {
-                if (registry.stageSelection != 6) {
-					 player.health -= 3;
-				}
-
-				if (player.health <= 0)
-                {
-          
-// 					registry.winner = player.side == 1 ? 2 : 1;
-// 					createBackground(renderer, 	window_width_px, window_height_px);
-
-					player.health = 0;
-                    if (!registry.deathTimers.has(entity)) registry.deathTimers.emplace(entity);
-                    // end music
-                    Mix_PlayChannel(-1, end_music, 0);
-                    Motion &motion = registry.motions.get(entity);
-                    motion.angle = M_PI / 2;
-                    motion.scale.y = motion.scale.y / 2;
-                    movable = false;
-					if (side == 1) {
-						num_p2_wins++;
-
-					} else if (side == 2) {
-						num_p1_wins++;
-					}
-					rounds--;
-                }
-				if (side == 1) explosion.damagable1 = false;
-				else explosion.damagable2 = false;
-            }
-        }
-
-        if (registry.players.has(entity) && registry.lasers2.has(entity_other))
-        {
-            Laser2& laser2 = registry.lasers2.get(entity_other);
-            if (registry.players.get(entity).side != registry.lasers2.get(entity_other).side && laser2.damagable) {
-                Player& player = registry.players.get(entity);
-                if (registry.stageSelection != 6) {
-					 player.health -= 3;
-				}
-		
-				if (player.health <= 0)
-                {
-// 					registry.winner = player.side == 1 ? 2 : 1;
-// 					createBackground(renderer, 	window_width_px, window_height_px);
-
-					player.health = 0;
-                    if (!registry.deathTimers.has(entity)) registry.deathTimers.emplace(entity);
-                    // end music
-                    Mix_PlayChannel(-1, end_music, 0);
-                    Motion &motion = registry.motions.get(entity);
-                    motion.angle = M_PI / 2;
-                    motion.scale.y = motion.scale.y / 2;
-                    movable = false;
-					if (player.side == 1) {
-						num_p2_wins++;
-
-					} else if (player.side == 2) {
-						num_p1_wins++;
-					}
-					rounds--;
-                }
-				
-                laser2.damagable = false;
-            }
-        }
 	}	
 	// Remove all collisions from this simulation step
 	registry.collisions.clear();
 }
 
 // Should the game be over ?
+void WorldSystem::replay_key(int key, int action)
+{
+	on_key(key, 0, action, 0);
+}
+
+void WorldSystem::seed_random(unsigned int seed)
+{
+	rng.seed(seed);
+}
+
 bool WorldSystem::is_over() const
 {
 	return bool(glfwWindowShouldClose(window));
@@ -1000,9 +948,10 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 		if (key == GLFW_KEY_RIGHT_SHIFT) {
 			if (action == GLFW_PRESS && player2_item) {
 				player2_item = false;
-				if (!p2.items.empty()) {
-					Item item = p2.items.front();
-					p2.items.pop();
+				ItemRing& items2 = registry.inventories.get(player2).items;
+				if (!items2.empty()) {
+					Item item = items2.front();
+					items2.pop();
 					if (item.id == 0) {
 						p2.health += 3;
 						Mix_PlayChannel(-1, healthpickup_sound, 0);
@@ -1012,8 +961,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 						int dir = 0;
 						if (p2.direction == 0) dir = -1;
 						else dir = 1;
-						createLaserBeam2(motion2.position + vec2({abs(motion2.scale.x / 2) * dir, 0.f}), p2.direction, p2.side);
-						Mix_PlayChannel(-1, laser2_sound, 0);
+						fire_laser2(motion2.position + vec2({abs(motion2.scale.x / 2) * dir, 0.f}), p2.direction, p2.side);
 					}
 				}
 			} else if (action == GLFW_RELEASE) {
@@ -1024,9 +972,10 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 		if (key == GLFW_KEY_3) {
 			if (action == GLFW_PRESS && player1_item) {
 				player1_item = false;
-				if (!p1.items.empty()) {
-					Item item = p1.items.front();
-					p1.items.pop();
+				ItemRing& items1 = registry.inventories.get(player1).items;
+				if (!items1.empty()) {
+					Item item = items1.front();
+					items1.pop();
 					if (item.id == 0) {
 						p1.health += 3;
 						
@@ -1037,8 +986,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 						int dir = 0;
 						if (p1.direction == 0) dir = -1;
 						else dir = 1;
-						createLaserBeam2(motion1.position + vec2({abs(motion1.scale.x / 2) * dir, 0.f}), p1.direction, p1.side);
-						Mix_PlayChannel(-1, laser2_sound, 0);
+						fire_laser2(motion1.position + vec2({abs(motion1.scale.x / 2) * dir, 0.f}), p1.direction, p1.side);
 					}
 				}
 			} else if (action == GLFW_RELEASE) {
@@ -1204,7 +1152,7 @@ void WorldSystem::on_mouse_move(vec2 mouse_position)
 	(vec2) mouse_position; // dummy to avoid compiler warning
 }
 
-void WorldSystem::updateLaserVelocity(Entity laserEntity, Motion& player1Motion, Motion& player2Motion) {
+void WorldSystem::updateLaserVelocity(Entity laserEntity, const Motion& player1Motion, const Motion& player2Motion) {
     Motion& laserMotion = registry.motions.get(laserEntity);
     vec2 player1Pos = player1Motion.position;
     vec2 player2Pos = player2Motion.position;
@@ -1231,8 +1179,8 @@ void WorldSystem::initializeLaserAI() {
     auto trackPlayerAction = [this]() {if (!registry.lasers.entities.empty()) {
         Entity laserEntity = registry.lasers.entities.front();
         Motion& laserMotion = registry.motions.get(laserEntity);
-        Motion& player1Motion = registry.motions.get(player1);
-        Motion& player2Motion = registry.motions.get(player2);
+        const Motion& player1Motion = registry.motions.peek(player1);
+        const Motion& player2Motion = registry.motions.peek(player2);
 
         vec2 targetPosition = (calculateDistance(laserMotion.position, player1Motion.position) <
                                calculateDistance(laserMotion.position, player2Motion.position)) ?
@@ -1245,11 +1193,11 @@ void WorldSystem::initializeLaserAI() {
     if (registry.lasers.entities.empty()) return;
 
     Entity laserEntity = registry.lasers.entities.front();
-    Motion& laserMotion = registry.motions.get(laserEntity);
+    const Motion& laserMotion = registry.motions.peek(laserEntity);
 
     // Determine the nearest player’s position as the laser target
-    Motion& player1Motion = registry.motions.get(player1);
-    Motion& player2Motion = registry.motions.get(player2);
+    const Motion& player1Motion = registry.motions.peek(player1);
+    const Motion& player2Motion = registry.motions.peek(player2);
     target = (calculateDistance(laserMotion.position, player1Motion.position) <
                       calculateDistance(laserMotion.position, player2Motion.position))
                          ? player1Motion.position
@@ -1270,9 +1218,9 @@ void WorldSystem::initializeLaserAI() {
     auto isPlayerInRange = [this]() -> bool {
         if (registry.lasers.entities.empty()) return false;
         Entity laserEntity = registry.lasers.entities.front();
-        Motion& laserMotion = registry.motions.get(laserEntity);
-        Motion& playerMotion1 = registry.motions.get(player1);
-        Motion& playerMotion2 = registry.motions.get(player2);
+        const Motion& laserMotion = registry.motions.peek(laserEntity);
+        const Motion& playerMotion1 = registry.motions.peek(player1);
+        const Motion& playerMotion2 = registry.motions.peek(player2);
 		currentDelay = 0.0f;
 
         float distanceToPlayer1 = calculateDistance(laserMotion.position, playerMotion1.position);
@@ -1294,9 +1242,9 @@ void WorldSystem::initializeLaserAI() {
 bool WorldSystem::isPlayerInRange() {
 	if (registry.lasers.entities.empty()) return false;
 	Entity laserEntity = registry.lasers.entities.front();
-	Motion& laserMotion = registry.motions.get(laserEntity);
-	Motion& playerMotion1 = registry.motions.get(player1);
-	Motion& playerMotion2 = registry.motions.get(player2);
+	const Motion& laserMotion = registry.motions.peek(laserEntity);
+	const Motion& playerMotion1 = registry.motions.peek(player1);
+	const Motion& playerMotion2 = registry.motions.peek(player2);
 
 	float distanceToPlayer1 = calculateDistance(laserMotion.position, playerMotion1.position);
 	float distanceToPlayer2 = calculateDistance(laserMotion.position, playerMotion2.position);
@@ -1308,15 +1256,16 @@ bool WorldSystem::isPlayerInRange() {
 // Laser collision handling function
 void WorldSystem::handleLaserCollisions() {
     for (Entity laserEntity : registry.lasers.entities) {
-        Motion& laserMotion = registry.motions.get(laserEntity);
+        const Motion& laserMotion = registry.motions.peek(laserEntity);
 
-        // Check collision with each player
-        for (Entity playerEntity : registry.players.entities) {
+        // Check collision with each player near the laser
+        physics->overlap_circle(laserMotion.position, laserRange, layer_bit(COLLISION_LAYER::PLAYER), query_results);
+        for (Entity playerEntity : query_results) {
+            if (!registry.players.has(playerEntity)) continue;
             Player& player = registry.players.get(playerEntity);
-            Motion& playerMotion = registry.motions.get(playerEntity);
 
             // Check if player is in laser path using a helper function
-            if (isLaserInRange(laserMotion.position, playerMotion.position) & movable) {
+            if (isLaserInRange(laserMotion.position, registry.motions.peek(playerEntity).position) & movable) {
                 // Reduce player health by 1 on laser hit
 				if (player.health != 0) {
 					if (registry.stageSelection != 6) {
@@ -1329,6 +1278,7 @@ void WorldSystem::handleLaserCollisions() {
 						player.health = 0;
 						registry.deathTimers.emplace(playerEntity);
 						Mix_PlayChannel(-1, end_music, 0);
+						Motion& playerMotion = registry.motions.get(playerEntity);
 						playerMotion.angle = M_PI / 2;
 						playerMotion.scale.y = playerMotion.scale.y / 2;
 						movable = false;
@@ -1339,6 +1289,62 @@ void WorldSystem::handleLaserCollisions() {
     }
 }
 
+// A grenade goes off: the explosion is only drawn, the players in its reach are hit right away
+void WorldSystem::explode(vec2 position)
+{
+	Entity explosion = createExplosion(position);
+	Mix_PlayChannel(-1, explosion_sound, 0);
+
+	BroadphaseBox reach = bounding_box(registry.motions.peek(explosion));
+	physics->overlap_aabb(reach.min, reach.max, layer_bit(COLLISION_LAYER::PLAYER), query_results);
+	for (Entity entity : query_results)
+		if (registry.players.has(entity)) damage_player(entity, 3);
+}
+
+// The long laser: the beam is only drawn, the first opponent in its path is hit when it is fired
+void WorldSystem::fire_laser2(vec2 start, int direction, int side)
+{
+	Entity beam = createLaserBeam2(start, direction, side);
+	Mix_PlayChannel(-1, laser2_sound, 0);
+
+	const Motion& motion = registry.motions.peek(beam);
+	vec2 end = 2.f * motion.position - start;
+	physics->segment_sweep(start, end, { 0.f, abs(motion.scale.y) / 2 }, layer_bit(COLLISION_LAYER::PLAYER), query_hits);
+	for (const QueryHit& hit : query_hits) {
+		if (registry.players.has(hit.entity) && registry.players.peek(hit.entity).side != side) {
+			damage_player(hit.entity, 3);
+			break;
+		}
+	}
+}
+
+// Damage from explosions and the long laser, the last hit ends the round
+void WorldSystem::damage_player(Entity entity, int damage)
+{
+	Player& player = registry.players.get(entity);
+	if (registry.stageSelection != 6) {
+		player.health -= damage;
+	}
+
+	if (player.health <= 0)
+	{
+		player.health = 0;
+		if (!registry.deathTimers.has(entity)) registry.deathTimers.emplace(entity);
+		// end music
+		Mix_PlayChannel(-1, end_music, 0);
+		Motion &motion = registry.motions.get(entity);
+		motion.angle = M_PI / 2;
+		motion.scale.y = motion.scale.y / 2;
+		movable = false;
+		if (player.side == 1) {
+			num_p2_wins++;
+		} else if (player.side == 2) {
+			num_p1_wins++;
+		}
+		rounds--;
+	}
+}
+
 // Check if the player is within the laser's range
 bool WorldSystem::isLaserInRange(vec2 laserPosition, vec2 playerPosition) {
     float distance = calculateDistance(laserPosition, playerPosition);
@@ -1457,7 +1463,7 @@ void WorldSystem::on_mouse_button(int button, int action, int mods) {
 // Function to check if the mouse is over the entity
 bool WorldSystem::isMouseOverEntity(vec2 mouse_position, Entity entity) {
 	if (registry.stageSelection != 0) return false;
-    Motion& motion = registry.motions.get(entity);
+    const Motion& motion = registry.motions.peek(entity);
 
     return (mouse_position.x >= motion.position.x - motion.scale.x / 2 &&
             mouse_position.x <= motion.position.x + motion.scale.x / 2 &&
@@ -1468,7 +1474,7 @@ bool WorldSystem::isMouseOverEntity(vec2 mouse_position, Entity entity) {
 void WorldSystem::handleEntityClick(Entity entity) {
     // Implement your logic here, e.g., selecting the entity or triggering an action
 	if (registry.stages.has(entity)) {
-		StageChoice& s = registry.stages.get(entity);
+		const StageChoice& s = registry.stages.peek(entity);
 		registry.stageSelection = s.stage;
 		Mix_PlayChannel(-1, select_music, 0);
 		restart_game();
@@ -1495,8 +1501,8 @@ void WorldSystem::loadMatchRecords() {
 }
 
 void WorldSystem::recordMatchResult() {
-	Player& player1Component = registry.players.get(player1);
-    Player& player2Component = registry.players.get(player2);
+	const Player& player1Component = registry.players.peek(player1);
+    const Player& player2Component = registry.players.peek(player2);
 
 	int player1hp = player1Component.health <= 0? 0: player1Component.health;
 	int player2hp =  player2Component.health <= 0? 0: player2Component.health;
@@ -1528,17 +1534,19 @@ void WorldSystem::createStage(int currentStage) {
 	if (currentStage != 4) {
 		player1 = createPlayer(renderer, 1, {200, stage.groundPositions[0].y}, 1);
 		player2 = createPlayer(renderer, 2, {window_width_px - 200, stage.groundPositions[0].y}, 0);
-		Motion& player1Motion = registry.motions.get(player1);
-		Motion& player2Motion = registry.motions.get(player2);
-		gun1 = createGun(renderer, 1, {player1Motion.position.x - 200, stage.groundPositions[0].y - 50});
-		gun2 = createGun(renderer, 2, {player2Motion.position.x - 150, stage.groundPositions[0].y - 50});
+		// copies, createGun emplaces into motions
+		const float player1X = registry.motions.peek(player1).position.x;
+		const float player2X = registry.motions.peek(player2).position.x;
+		gun1 = createGun(renderer, 1, {player1X - 200, stage.groundPositions[0].y - 50});
+		gun2 = createGun(renderer, 2, {player2X - 150, stage.groundPositions[0].y - 50});
 	} else {
 		player1 = createPlayer(renderer, 1, {200, stage.platformPositions[0].y}, 1);
 		player2 = createPlayer(renderer, 2, {window_width_px - 200, stage.platformPositions[0].y}, 0);
-		Motion& player1Motion = registry.motions.get(player1);
-		Motion& player2Motion = registry.motions.get(player2);
-		gun1 = createGun(renderer, 1, {player1Motion.position.x - 200, stage.platformPositions[0].y - 50});
-		gun2 = createGun(renderer, 2, {player2Motion.position.x - 150, stage.platformPositions[0].y - 50});
+		// copies, createGun emplaces into motions
+		const float player1X = registry.motions.peek(player1).position.x;
+		const float player2X = registry.motions.peek(player2).position.x;
+		gun1 = createGun(renderer, 1, {player1X - 200, stage.platformPositions[0].y - 50});
+		gun2 = createGun(renderer, 2, {player2X - 150, stage.platformPositions[0].y - 50});
 	}
 
 
@@ -14,6 +14,7 @@
 #include <SDL_mixer.h>
 
 #include "render_system.hpp"
+#include "physics_system.hpp"
 
 #include "animation_system.hpp"
 #include "DecisionTree.hpp"
@@ -43,7 +44,7 @@ public:
 	GLFWwindow* create_window();
 
 	// starts the game
-	void init(RenderSystem* renderer);
+	void init(RenderSystem* renderer, PhysicsSystem* physics);
 
 	// Releases all associated resources
 	~WorldSystem();
@@ -51,6 +52,9 @@ public:
 	// Steps the game ahead by ms milliseconds
 	bool step(float elapsed_ms);
 
+	// Updates fps, once per rendered frame
+	void count_frame(float elapsed_ms);
+
 	// for keeping track of remaining shots
 	int remaining_bullet_shots_p1 = 10;
 	int remaining_bullet_shots_p2 = 10;
@@ -60,6 +64,11 @@ public:
 	// Check for collisions
 	void handle_collisions();
 
+	// For replays without a window (see bench/replay_hash.cpp): a key event as if it came from the window, and a
+	// fixed seed for the random number generator
+	void replay_key(int key, int action);
+	void seed_random(unsigned int seed);
+
 	// Should the game be over ?
 	bool is_over()const;
 
@@ -103,14 +112,23 @@ private:
 	// restart level
 	void restart_game();
 
+	// Weapons that hit through the physics queries instead of a collision entity
+	void explode(vec2 position);
+	void fire_laser2(vec2 start, int direction, int side);
+	void damage_player(Entity entity, int damage);
+
 	// 
 	bool movable = true;
 
 	// OpenGL window handle
-	GLFWwindow* window;
+	GLFWwindow* window = nullptr;
 
 	// Game state
 	RenderSystem* renderer;
+	PhysicsSystem* physics;
+	// kept for the physics queries, to avoid allocating for each
+	std::vector<Entity> query_results;
+	std::vector<QueryHit> query_hits;
 	AnimationSystem animation_system;
 	float current_speed;
 	Entity player1;
@@ -145,34 +163,34 @@ private:
 	Entity portal2;
 
 	// music references
-	Mix_Music* snow_music;
-	Mix_Music* city_music;
-	Mix_Music* desert_music;
-	Mix_Music* mapselections_music;
-	Mix_Music* tutorial_music;
+	Mix_Music* snow_music = nullptr;
+	Mix_Music* city_music = nullptr;
+	Mix_Music* desert_music = nullptr;
+	Mix_Music* mapselections_music = nullptr;
+	Mix_Music* tutorial_music = nullptr;
 	
 
-	Mix_Chunk* end_music;
-	Mix_Chunk* hit_sound;
-	Mix_Chunk* shoot_sound;
-	Mix_Chunk* laser_sound;
-	Mix_Chunk* salmon_dead_sound;
-	Mix_Chunk* salmon_eat_sound;
-	Mix_Chunk* portal_sound;
-	Mix_Chunk* buck_shot_sound;
-	Mix_Chunk* select_music;
+	Mix_Chunk* end_music = nullptr;
+	Mix_Chunk* hit_sound = nullptr;
+	Mix_Chunk* shoot_sound = nullptr;
+	Mix_Chunk* laser_sound = nullptr;
+	Mix_Chunk* salmon_dead_sound = nullptr;
+	Mix_Chunk* salmon_eat_sound = nullptr;
+	Mix_Chunk* portal_sound = nullptr;
+	Mix_Chunk* buck_shot_sound = nullptr;
+	Mix_Chunk* select_music = nullptr;
 	
-	Mix_Chunk* laser2_sound;
-	Mix_Chunk* healthpickup_sound;
-	Mix_Chunk* explosion_sound;
-	Mix_Chunk* reload_sound;
+	Mix_Chunk* laser2_sound = nullptr;
+	Mix_Chunk* healthpickup_sound = nullptr;
+	Mix_Chunk* explosion_sound = nullptr;
+	Mix_Chunk* reload_sound = nullptr;
 
 	// C++ random number generator
 	std::default_random_engine rng;
 	std::uniform_real_distribution<float> uniform_dist; // number between 0..1
 
   	float calculateDistance(vec2 pos1, vec2 pos2);
-	void updateLaserVelocity(Entity laserEntity, Motion& player1Motion, Motion& player2Motion);
+	void updateLaserVelocity(Entity laserEntity, const Motion& player1Motion, const Motion& player2Motion);
 	DecisionTreeNode* rootNode;
   	float laserRange = 10.0f;
   	float laserCoolDownTime = 2000.0f;  // CoolDown time in milliseconds